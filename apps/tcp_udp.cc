@@ -48,6 +48,7 @@ static void check_argc(int argc, char **argv, int curr, const char *err) {
 
 static tuple<TCPConfig, FdAdapterConfig, bool> get_config(int argc, char **argv) {
     TCPConfig c_fsm{};
+    c_fsm.fast_retransmit = true;
     FdAdapterConfig c_filt{};
 
     int curr = 1;
@@ -11,6 +11,7 @@ add_test(NAME t_recv_transmit        COMMAND recv_transmit)
 add_test(NAME t_recv_window          COMMAND recv_window)
 add_test(NAME t_recv_reorder         COMMAND recv_reorder)
 add_test(NAME t_recv_close           COMMAND recv_close)
+add_test(NAME t_recv_sack            COMMAND recv_sack)
 
 add_test(NAME t_send_connect         COMMAND send_connect)
 add_test(NAME t_send_transmit        COMMAND send_transmit)
@@ -18,6 +19,11 @@ add_test(NAME t_send_retx            COMMAND send_retx)
 add_test(NAME t_send_window          COMMAND send_window)
 add_test(NAME t_send_ack             COMMAND send_ack)
 add_test(NAME t_send_close           COMMAND send_close)
+add_test(NAME t_send_congestion      COMMAND send_congestion)
+add_test(NAME t_send_fast_recovery   COMMAND send_fast_recovery)
+add_test(NAME t_send_rto             COMMAND send_rto)
+add_test(NAME t_send_sack            COMMAND send_sack)
+add_test(NAME t_send_pacing          COMMAND send_pacing)
 
 add_test(NAME t_strm_reassem_cap         COMMAND fsm_stream_reassembler_cap)
 add_test(NAME t_strm_reassem_single      COMMAND fsm_stream_reassembler_single)
@@ -27,12 +33,16 @@ add_test(NAME t_strm_reassem_holes       COMMAND fsm_stream_reassembler_holes)
 add_test(NAME t_strm_reassem_many        COMMAND fsm_stream_reassembler_many)
 add_test(NAME t_strm_reassem_overlapping COMMAND fsm_stream_reassembler_overlapping)
 add_test(NAME t_strm_reassem_win         COMMAND fsm_stream_reassembler_win)
+add_test(NAME t_strm_reassem_buffer      COMMAND fsm_stream_reassembler_buffer)
+add_test(NAME t_strm_reassem_intervals   COMMAND fsm_stream_reassembler_intervals)
+add_test(NAME t_strm_reassem_fast_path   COMMAND fsm_stream_reassembler_fast_path)
 
 add_test(NAME t_byte_stream_construction COMMAND byte_stream_construction)
 add_test(NAME t_byte_stream_one_write    COMMAND byte_stream_one_write)
 add_test(NAME t_byte_stream_two_writes   COMMAND byte_stream_two_writes)
 add_test(NAME t_byte_stream_capacity     COMMAND byte_stream_capacity)
 add_test(NAME t_byte_stream_many_writes  COMMAND byte_stream_many_writes)
+add_test(NAME t_byte_stream_buffers     COMMAND byte_stream_buffers)
 
 add_test(NAME t_webget               COMMAND "${PROJECT_SOURCE_DIR}/tests/webget_t.sh")
 
@@ -42,6 +52,16 @@ add_test(NAME router_test    COMMAND network_simulator)
 
 add_test(NAME t_tcp_parser           COMMAND tcp_parser "${PROJECT_SOURCE_DIR}/tests/ipv4_parser.data")
 add_test(NAME t_ipv4_parser          COMMAND ipv4_parser "${PROJECT_SOURCE_DIR}/tests/ipv4_parser.data")
+add_test(NAME t_tcp_options          COMMAND tcp_options)
+add_test(NAME t_tcp_split            COMMAND tcp_split)
+add_test(NAME t_tcp_coalesce         COMMAND tcp_coalesce)
+add_test(NAME t_tcp_receive_storage  COMMAND tcp_receive_storage)
+add_test(NAME t_tcp_socket_cork      COMMAND tcp_socket_cork)
+add_test(NAME t_eventloop            COMMAND eventloop)
+add_test(NAME t_tcp_stack            COMMAND tcp_stack)
+add_test(NAME t_tcp_sharded_stack    COMMAND tcp_sharded_stack)
+add_test(NAME t_timing_wheel         COMMAND timing_wheel)
+add_test(NAME t_internet_checksum    COMMAND internet_checksum)
 add_test(NAME t_active_close         COMMAND fsm_active_close)
 add_test(NAME t_passive_close        COMMAND fsm_passive_close)
 add_test(NAME ec_ack_rst             COMMAND fsm_ack_rst)
@@ -53,6 +73,11 @@ add_test(NAME t_connect              COMMAND fsm_connect_relaxed)
 add_test(NAME ec_listen              COMMAND fsm_listen)
 add_test(NAME t_listen               COMMAND fsm_listen_relaxed)
 add_test(NAME t_winsize              COMMAND fsm_winsize)
+add_test(NAME t_winscale             COMMAND fsm_winscale)
+add_test(NAME t_timestamps           COMMAND fsm_timestamps)
+add_test(NAME t_mss                  COMMAND fsm_mss)
+add_test(NAME t_delack               COMMAND fsm_delack)
+add_test(NAME t_nagle                COMMAND fsm_nagle)
 add_test(NAME ec_retx                COMMAND fsm_retx)
 add_test(NAME t_retx                 COMMAND fsm_retx_relaxed)
 add_test(NAME t_retx_win             COMMAND fsm_retx_win)
@@ -13,31 +13,56 @@ void DUMMY_CODE(Targs &&.../* unused */) {}
 using namespace std;
 
 ByteStream::ByteStream(const size_t capacity)
-    : _queue(), _cap_size(capacity), _write_size(0), _read_size(0), _end_input(false), _error(false) {}
+    : _cap_size(capacity), _write_size(0), _read_size(0), _end_input(false), _error(false) {}
 
 size_t ByteStream::write(const string &data) {
     if (_end_input)
         return 0;
-    size_t write_size = min(data.size(), _cap_size - _queue.size());
+    return write(Buffer{data.substr(0, remaining_capacity())});
+}
+
+size_t ByteStream::write(string &&data) { return write(Buffer::compacted(move(data))); }
+
+//! \details The accepted prefix of `data` is stored as a single chunk that shares storage with `data`.
+size_t ByteStream::write(Buffer data) {
+    if (_end_input)
+        return 0;
+    size_t write_size = min(data.size(), remaining_capacity());
+    if (write_size == 0)
+        return 0;
+    data.remove_suffix(data.size() - write_size);
+    _buffers.push_back(move(data));
+    _buffer_size += write_size;
     _write_size += write_size;
-    for (size_t i = 0; i < write_size; ++i) {
-        _queue.push_back(data[i]);
-    }
     return write_size;
 }
 
 //! \param[in] len bytes will be copied from the output side of the buffer
 string ByteStream::peek_output(const size_t len) const {
-    size_t pop_size = min(len, _queue.size());
-    return string(_queue.begin(), _queue.begin() + pop_size);
+    size_t peek_size = min(len, _buffer_size);
+    string ret;
+    ret.reserve(peek_size);
+    for (const auto &buf : _buffers) {
+        if (ret.size() == peek_size)
+            break;
+        ret.append(buf.str().substr(0, peek_size - ret.size()));
+    }
+    return ret;
 }
 
 //! \param[in] len bytes will be removed from the output side of the buffer
 void ByteStream::pop_output(const size_t len) {
-    size_t pop_size = min(len, _queue.size());
+    size_t pop_size = min(len, _buffer_size);
+    _buffer_size -= pop_size;
     _read_size += pop_size;
-    for (size_t i = 0; i < pop_size; ++i) {
-        _queue.pop_front();
+    while (pop_size > 0) {
+        Buffer &front = _buffers.front();
+        if (pop_size < front.size()) {
+            front.remove_prefix(pop_size);
+            break;
+        }
+        pop_size -= front.size();
+        _buffers.pop_front();
     }
 }
 
@@ -50,18 +75,54 @@ std::string ByteStream::read(const size_t len) {
     return data;
 }
 
+//! \param[in] len bytes will be referenced from the output side of the buffer
+//! \details The returned Buffers alias the stream's chunks, so no bytes are copied.
+BufferList ByteStream::peek_buffers(const size_t len) const {
+    size_t remaining = min(len, _buffer_size);
+    BufferList ret;
+    for (const auto &buf : _buffers) {
+        if (remaining == 0)
+            break;
+        Buffer slice = buf;
+        if (slice.size() > remaining) {
+            slice.remove_suffix(slice.size() - remaining);
+        }
+        remaining -= slice.size();
+        ret.append(slice);
+    }
+    return ret;
+}
+
+//! \param[in] len bytes will be popped and returned
+//! \details If the bytes span more than one chunk they are concatenated into a new Buffer;
+//! otherwise the result shares storage with the chunk it came from.
+Buffer ByteStream::read_buffer(const size_t len) {
+    size_t read_size = min(len, _buffer_size);
+    if (read_size == 0)
+        return {};
+    Buffer ret;
+    if (_buffers.front().size() >= read_size) {
+        ret = _buffers.front();
+        ret.remove_suffix(ret.size() - read_size);
+    } else {
+        ret = Buffer{peek_output(read_size)};
+    }
+    pop_output(read_size);
+    return ret;
+}
+
 void ByteStream::end_input() { _end_input = true; }
 
 bool ByteStream::input_ended() const { return _end_input; }
 
-size_t ByteStream::buffer_size() const { return _queue.size(); }
+size_t ByteStream::buffer_size() const { return _buffer_size; }
 
-bool ByteStream::buffer_empty() const { return _queue.empty(); }
+bool ByteStream::buffer_empty() const { return _buffer_size == 0; }
 
-bool ByteStream::eof() const { return _end_input && _queue.empty(); }
+bool ByteStream::eof() const { return _end_input && buffer_empty(); }
 
 size_t ByteStream::bytes_written() const { return _write_size; }
 
 size_t ByteStream::bytes_read() const { return _read_size; }
 
-size_t ByteStream::remaining_capacity() const { return _cap_size - _queue.size(); }
+size_t ByteStream::remaining_capacity() const { return _cap_size - _buffer_size; }
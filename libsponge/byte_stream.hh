@@ -1,6 +1,8 @@
 #ifndef SPONGE_LIBSPONGE_BYTE_STREAM_HH
 #define SPONGE_LIBSPONGE_BYTE_STREAM_HH
 
+#include "buffer.hh"
+
 #include <cstddef>
 #include <deque>
 #include <string>
@@ -18,7 +20,12 @@ class ByteStream {
     // all, but if any of your tests are taking longer than a second,
     // that's a sign that you probably want to keep exploring
     // different approaches.
-    std::deque<char> _queue;
+
+    //! Unread bytes, stored as the chunks they were written in. Writes append
+    //! a chunk and pops trim chunks from the front, so neither touches
+    //! individual bytes.
+    std::deque<Buffer> _buffers{};
+    size_t _buffer_size{0};  //!< Total number of bytes held in `_buffers`
     size_t _cap_size;
     size_t _write_size;
     size_t _read_size;
@@ -38,6 +45,15 @@ class ByteStream {
     //! \returns the number of bytes accepted into the stream
     size_t write(const std::string &data);
 
+    //! Write a string of bytes into the stream, taking ownership of its storage
+    //! (which is first shrunk if it is mostly spare; see Buffer::compacted()).
+    //! \returns the number of bytes accepted into the stream
+    size_t write(std::string &&data);
+
+    //! Write a Buffer into the stream without copying its bytes.
+    //! \returns the number of bytes accepted into the stream
+    size_t write(Buffer data);
+
     //! \returns the number of additional bytes that the stream has space for
     size_t remaining_capacity() const;
 
@@ -62,6 +78,14 @@ class ByteStream {
     //! \returns a string
     std::string read(const size_t len);
 
+    //! Peek at next "len" bytes of the stream without copying them
+    //! \returns a BufferList sharing storage with the stream
+    BufferList peek_buffers(const size_t len) const;
+
+    //! Read (i.e., pop) the next "len" bytes of the stream as a single Buffer
+    //! \returns a Buffer sharing storage with the stream whenever the bytes were written by one write()
+    Buffer read_buffer(const size_t len);
+
     //! \returns `true` if the stream input has ended
     bool input_ended() const;
 
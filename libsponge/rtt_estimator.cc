@@ -0,0 +1,26 @@
+#include "rtt_estimator.hh"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+//! \param[in] rtt_ms time between sending a segment and receiving its acknowledgment, in milliseconds
+void RTTEstimator::sample(const uint64_t rtt_ms) {
+    const double r = static_cast<double>(rtt_ms);
+    if (not _has_sample) {
+        _srtt = r;
+        _rttvar = r / 2;
+        _has_sample = true;
+        return;
+    }
+
+    // RTTVAR is updated first, with the SRTT from before this sample
+    _rttvar = (1 - BETA) * _rttvar + BETA * abs(_srtt - r);
+    _srtt = (1 - ALPHA) * _srtt + ALPHA * r;
+}
+
+unsigned RTTEstimator::rto() const {
+    const double rto = ceil(_srtt + max(GRANULARITY, K * _rttvar));
+    return static_cast<unsigned>(clamp(rto, static_cast<double>(_rto_min), static_cast<double>(_rto_max)));
+}
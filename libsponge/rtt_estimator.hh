@@ -0,0 +1,49 @@
+#ifndef SPONGE_LIBSPONGE_RTT_ESTIMATOR_HH
+#define SPONGE_LIBSPONGE_RTT_ESTIMATOR_HH
+
+#include "tcp_config.hh"
+
+#include <cstdint>
+
+//! \brief Round-trip time estimator that computes the retransmission timeout (\ref rfc::rfc6298 "RFC 6298")
+
+//! Keeps the smoothed round-trip time (SRTT) and its mean deviation (RTTVAR), both in
+//! milliseconds. The caller is responsible for Karn's algorithm: samples must only come
+//! from segments that were never retransmitted.
+class RTTEstimator {
+  private:
+    static constexpr double ALPHA = 1.0 / 8;  //!< Gain of the SRTT filter
+    static constexpr double BETA = 1.0 / 4;   //!< Gain of the RTTVAR filter
+    static constexpr unsigned K = 4;          //!< Weight of RTTVAR in the retransmission timeout
+    static constexpr double GRANULARITY = 1;  //!< Clock granularity, in milliseconds
+
+    unsigned _rto_min;        //!< Lower bound on rto()
+    unsigned _rto_max;        //!< Upper bound on rto()
+    bool _has_sample{false};  //!< Has any sample been taken yet?
+    double _srtt{0};          //!< Smoothed round-trip time
+    double _rttvar{0};        //!< Round-trip time variation
+
+  public:
+    //! \param[in] rto_min lower bound on the retransmission timeout, in milliseconds
+    //! \param[in] rto_max upper bound on the retransmission timeout, in milliseconds
+    RTTEstimator(const unsigned rto_min = TCPConfig::RTO_MIN_DFLT, const unsigned rto_max = TCPConfig::RTO_MAX_DFLT)
+        : _rto_min(rto_min), _rto_max(rto_max) {}
+
+    //! \brief Fold in a new round-trip time measurement
+    void sample(const uint64_t rtt_ms);
+
+    //! \name Accessors
+    //!@{
+    bool has_sample() const { return _has_sample; }  //!< Has any sample been taken yet?
+    double srtt() const { return _srtt; }            //!< Smoothed round-trip time, in milliseconds
+    double rttvar() const { return _rttvar; }        //!< Round-trip time variation, in milliseconds
+
+    //! \brief Retransmission timeout, SRTT + max(G, 4 * RTTVAR) clamped to [rto_min, rto_max], in milliseconds
+    //! \note Only meaningful once has_sample() is true
+    unsigned rto() const;
+
+    unsigned rto_max() const { return _rto_max; }  //!< Upper bound on rto() and on backed-off timeouts
+    //!@}
+};
+
+#endif  // SPONGE_LIBSPONGE_RTT_ESTIMATOR_HH
@@ -13,93 +13,96 @@ void DUMMY_CODE(Targs &&.../* unused */) {}
 using namespace std;
 
 StreamReassembler::StreamReassembler(const size_t capacity)
-    : unass_base(0)
-    , unass_size(0)
-    , _eof(0)
-    , buffer(capacity, '\0')
-    , bitmap(capacity, false)
-    , _output(capacity)
-    , _capacity(capacity) {}
-
-//! \details This functions calls just after pushing a substring into the
-//! _output stream. It aims to check if there exists any contiguous substrings
-//! recorded earlier can be push into the stream.
+    : unass_base(0), unass_size(0), _eof(false), _eof_index(0), _segments(), _output(capacity), _capacity(capacity) {}
+
+//! \details This functions calls just after storing a substring. It pushes
+//! every stored substring that now starts at the first unassembled byte into
+//! the _output stream, without copying it.
 void StreamReassembler::check_contiguous() {
-    string tmp = "";
-    while (bitmap.front()) {
-        // cout<<"check one more contiguous substring"<<endl;
-        tmp += buffer.front();
-        buffer.pop_front();
-        bitmap.pop_front();
-        buffer.push_back('\0');
-        bitmap.push_back(false);
-    }
-    if (tmp.length() > 0) {
-        // cout << "push one contiguous substring with length " << tmp.length() << endl;
-        _output.write(tmp);
-        unass_base += tmp.length();
-        unass_size -= tmp.length();
+    while (!_segments.empty() && _segments.begin()->first == unass_base) {
+        Buffer &seg = _segments.begin()->second;
+        const size_t len = seg.size();
+        _output.write(move(seg));
+        unass_base += len;
+        unass_size -= len;
+        _segments.erase(_segments.begin());
     }
 }
 
-//! \details This function accepts a substring (aka a segment) of bytes,
-//! possibly out-of-order, from the logical stream, and assembles any newly
-//! contiguous substrings and writes them into the output stream in order.
-void StreamReassembler::push_substring(const string &data, const size_t index, const bool eof) {
-    // Set EOF flag if this is the last segment
-    if (eof) {
-        _eof = true;
+//! \details Stores `data`, which holds the bytes of the stream starting at `index`.
+//! Any stored substring lying entirely inside its range is replaced; partially overlapping
+//! neighbours are kept and `data` is trimmed to fit around them.
+void StreamReassembler::insert_segment(const size_t index, Buffer data) {
+    size_t begin = index;
+    size_t end = index + data.size();
+
+    // trim the front against the stored substring that starts at or before `begin`
+    auto it = _segments.upper_bound(begin);
+    if (it != _segments.begin()) {
+        const auto prev = std::prev(it);
+        begin = max(begin, prev->first + prev->second.size());
     }
-    size_t len = data.length();
 
-    // Handle empty data with EOF
-    if (len == 0 && _eof && unass_size == 0) {
-        _output.end_input();
-        return;
+    // absorb the stored substrings that the new range covers, and trim the back against the next one
+    while (begin < end && it != _segments.end() && it->first < end) {
+        const size_t seg_end = it->first + it->second.size();
+        if (seg_end > end) {
+            end = it->first;
+            break;
+        }
+        unass_size -= it->second.size();
+        it = _segments.erase(it);
     }
 
-    // Ignore data beyond capacity
-    if (index >= unass_base + _capacity)
+    if (begin >= end)
         return;
+    data.remove_prefix(begin - index);
+    data.remove_suffix(data.size() - (end - begin));
+    unass_size += data.size();
+    _segments.emplace_hint(it, begin, move(data));
+}
 
-    // Process data that starts at or after unass_base
-    if (index >= unass_base) {
-        int offset = index - unass_base;
+//! \details Only the bytes that fit in the window are copied out of `data`.
+void StreamReassembler::push_substring(const string &data, const size_t index, const bool eof) {
+    const size_t window_end = unass_base + _capacity - _output.buffer_size();
+    const size_t data_end = index + data.size();
+    const size_t end = clamp(window_end, index, data_end);
+    const size_t begin = clamp(unass_base, index, end);
+    push_substring(Buffer{data.substr(begin - index, end - begin)}, begin, eof && end == data_end);
+}
 
-        // Calculate how much of the data can actually be stored
-        size_t real_len = min(len, _capacity - _output.buffer_size() - offset);
+//! \details This function accepts a substring (aka a segment) of bytes,
+//! possibly out-of-order, from the logical stream, and assembles any newly
+//! contiguous substrings and writes them into the output stream in order.
+void StreamReassembler::push_substring(Buffer data, const size_t index, const bool eof) {
+    // The first byte that doesn't fit: capacity counts both the reassembled-but-unread bytes and the unassembled ones
+    const size_t window_end = unass_base + _capacity - _output.buffer_size();
+    const size_t data_end = index + data.size();
 
-        // Check if all data can be stored
-        if (real_len < len) {
-            _eof = false;
-        }
-        for (size_t i = 0; i < real_len; i++) {
-            if (bitmap[i + offset])
-                continue;
-            buffer[i + offset] = data[i];
-            bitmap[i + offset] = true;
-            unass_size++;
-        }
+    // Only remember EOF if the last byte of the stream fits in the window
+    if (eof && data_end <= window_end) {
+        _eof = true;
+        _eof_index = data_end;
     }
-    // Process data that overlaps with unass_base
-    else if (index + len > unass_base) {
-        int offset = unass_base - index;
-        size_t real_len = min(len - offset, _capacity - _output.buffer_size());
-        if (real_len < len - offset) {
-            _eof = false;
-        }
-        for (size_t i = 0; i < real_len; i++) {
-            if (bitmap[i])
-                continue;
-            buffer[i] = data[i + offset];
-            bitmap[i] = true;
-            unass_size++;
+
+    const size_t begin = max(index, unass_base);
+    const size_t end = min(data_end, window_end);
+    if (begin < end) {
+        data.remove_prefix(begin - index);
+        data.remove_suffix(data.size() - (end - begin));
+        if (begin == unass_base && (_segments.empty() || _segments.begin()->first >= end)) {
+            // Fast path: the substring continues the stream and overlaps nothing stored, so it
+            // goes straight to the output without passing through `_segments`
+            _output.write(move(data));
+            unass_base = end;
+        } else {
+            insert_segment(begin, move(data));
         }
+        check_contiguous();
     }
-    check_contiguous();
 
     // End input only if EOF is set and all data has been reassembled
-    if (_eof && unass_size == 0) {
+    if (_eof && unass_base == _eof_index) {
         _output.end_input();
     }
 }
@@ -108,4 +111,16 @@ size_t StreamReassembler::unassembled_bytes() const { return unass_size; }
 
 bool StreamReassembler::empty() const { return unass_size == 0; }
 
-size_t StreamReassembler::ack_index() const { return unass_base; }
\ No newline at end of file
+size_t StreamReassembler::ack_index() const { return unass_base; }
+
+vector<pair<uint64_t, uint64_t>> StreamReassembler::unassembled_ranges() const {
+    vector<pair<uint64_t, uint64_t>> ranges;
+    for (const auto &[index, data] : _segments) {
+        if (!ranges.empty() && ranges.back().second == index) {
+            ranges.back().second += data.size();
+        } else {
+            ranges.emplace_back(index, index + data.size());
+        }
+    }
+    return ranges;
+}
\ No newline at end of file
@@ -1,30 +1,38 @@
 #ifndef SPONGE_LIBSPONGE_STREAM_REASSEMBLER_HH
 #define SPONGE_LIBSPONGE_STREAM_REASSEMBLER_HH
 
+#include "buffer.hh"
 #include "byte_stream.hh"
 
 #include <algorithm>
 #include <cstdint>
 #include <deque>
 #include <iostream>
+#include <map>
 #include <string>
+#include <utility>
+#include <vector>
 
 //! \brief A class that assembles a series of excerpts from a byte stream (possibly out of order,
 //! possibly overlapping) into an in-order byte stream.
 class StreamReassembler {
   private:
     // Your code here -- add private members as necessary.
-    size_t unass_base;        //!< The index of the first unassembled byte
-    size_t unass_size;        //!< The number of bytes in the substrings stored but not yet reassembled
-    bool _eof;                //!< The last byte has arrived
-    std::deque<char> buffer;  //!< The unassembled strings
-    std::deque<bool> bitmap;  //!< buffer bitmap
+    size_t unass_base;  //!< The index of the first unassembled byte
+    size_t unass_size;  //!< The number of bytes in the substrings stored but not yet reassembled
+    bool _eof;          //!< The last byte has arrived
+    size_t _eof_index;  //!< The index just past the last byte of the stream (valid once `_eof` is set)
+
+    //! The unassembled substrings, keyed by the index of their first byte.
+    //! Stored substrings never overlap, so insertion and reassembly cost
+    //! scales with the number of substrings rather than the number of bytes.
+    std::map<size_t, Buffer> _segments;
 
     ByteStream _output;  //!< The reassembled in-order byte stream
     size_t _capacity;    //!< The maximum number of bytes
 
+    void insert_segment(const size_t index, Buffer data);
     void check_contiguous();
-    size_t real_size(const std::string &data, const size_t index);
 
   public:
     //! \brief Construct a `StreamReassembler` that will store up to `capacity` bytes.
@@ -42,6 +50,10 @@ class StreamReassembler {
     //! \param eof the last byte of `data` will be the last byte in the entire stream
     void push_substring(const std::string &data, const uint64_t index, const bool eof);
 
+    //! \brief Receive a substring held in a Buffer, storing it without copying its bytes.
+    //! \copydetails push_substring(const std::string &, const uint64_t, const bool)
+    void push_substring(Buffer data, const uint64_t index, const bool eof);
+
     //! \name Access the reassembled byte stream
     //!@{
     const ByteStream &stream_out() const { return _output; }
@@ -60,6 +72,10 @@ class StreamReassembler {
 
     //! The acknowledge index of the stream, i.e., the index of the next interested substring
     size_t ack_index() const;
+
+    //! \brief The ranges of stream indices held but not yet reassembled
+    //! \returns [first, last) index pairs in increasing order, with adjacent substrings merged
+    std::vector<std::pair<uint64_t, uint64_t>> unassembled_ranges() const;
 };
 
 #endif  // SPONGE_LIBSPONGE_STREAM_REASSEMBLER_HH
@@ -0,0 +1,116 @@
+#include "tcp_congestion_control.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace std;
+
+//! Initial window, in segments (RFC 6928)
+static constexpr size_t INITIAL_WINDOW_SEGMENTS = 10;
+
+//! \param[in] algorithm the congestion control algorithm to use
+//! \param[in] mss the sender maximum segment size
+unique_ptr<CongestionController> CongestionController::make(const TCPConfig::CongestionControl algorithm,
+                                                            const size_t mss) {
+    switch (algorithm) {
+        case TCPConfig::CongestionControl::NEWRENO:
+            return make_unique<NewReno>(mss);
+        case TCPConfig::CongestionControl::CUBIC:
+            return make_unique<Cubic>(mss);
+        case TCPConfig::CongestionControl::NONE:
+            break;
+    }
+    return nullptr;
+}
+
+NewReno::NewReno(const size_t mss)
+    : _mss(mss), _cwnd(INITIAL_WINDOW_SEGMENTS * mss), _ssthresh(numeric_limits<size_t>::max()) {}
+
+//! \details In slow start the window grows by at most one MSS per acknowledgment (appropriate byte
+//! counting with L = 1); in congestion avoidance it grows by one MSS per window's worth of acknowledged bytes.
+void NewReno::on_ack(const size_t acked_bytes, const uint64_t) {
+    if (_cwnd < _ssthresh) {
+        _cwnd += min(acked_bytes, _mss);
+        return;
+    }
+
+    _acked_in_avoidance += acked_bytes;
+    if (_acked_in_avoidance >= _cwnd) {
+        _acked_in_avoidance -= _cwnd;
+        _cwnd += _mss;
+    }
+}
+
+void NewReno::on_loss(const size_t bytes_in_flight, const uint64_t) {
+    _ssthresh = max(bytes_in_flight / 2, 2 * _mss);
+    _cwnd = _ssthresh;
+    _acked_in_avoidance = 0;
+}
+
+void NewReno::on_rto(const size_t bytes_in_flight, const uint64_t) {
+    _ssthresh = max(bytes_in_flight / 2, 2 * _mss);
+    _cwnd = _mss;
+    _acked_in_avoidance = 0;
+}
+
+Cubic::Cubic(const size_t mss)
+    : _mss(static_cast<double>(mss)), _cwnd(INITIAL_WINDOW_SEGMENTS), _ssthresh(numeric_limits<double>::infinity()) {}
+
+size_t Cubic::cwnd() const { return static_cast<size_t>(max(_cwnd, 1.0) * _mss); }
+
+size_t Cubic::ssthresh() const {
+    return isinf(_ssthresh) ? numeric_limits<size_t>::max() : static_cast<size_t>(_ssthresh * _mss);
+}
+
+void Cubic::on_ack(const size_t acked_bytes, const uint64_t now_ms) {
+    const double segments = acked_bytes / _mss;
+
+    if (_cwnd < _ssthresh) {
+        _cwnd += min(segments, 1.0);
+        return;
+    }
+
+    if (not _epoch_started) {
+        _epoch_started = true;
+        _epoch_start = now_ms;
+        if (_cwnd < _w_max) {
+            _k = cbrt((_w_max - _cwnd) / C);
+            _w_origin = _w_max;
+        } else {
+            _k = 0;
+            _w_origin = _cwnd;
+        }
+        _w_est = _cwnd;
+    }
+
+    // Grow towards W(t), but by no more than half the window per RTT's worth of acknowledgments
+    const double t = (now_ms - _epoch_start) / 1000.0;
+    const double target = min(_w_origin + C * pow(t - _k, 3), 1.5 * _cwnd);
+    if (target > _cwnd) {
+        _cwnd += (target - _cwnd) / _cwnd * segments;
+    } else {
+        _cwnd += segments / (100 * _cwnd);
+    }
+
+    // Reno-friendly region: never grow slower than Reno would with the same decrease factor
+    _w_est += 3 * (1 - BETA) / (1 + BETA) * segments / _cwnd;
+    _cwnd = max(_cwnd, _w_est);
+}
+
+void Cubic::reduce() {
+    // Fast convergence: release bandwidth to newer flows when the plateau keeps falling
+    _w_max = _cwnd < _w_max ? _cwnd * (1 + BETA) / 2 : _cwnd;
+    _ssthresh = max(_cwnd * BETA, 2.0);
+    _epoch_started = false;
+}
+
+void Cubic::on_loss(const size_t, const uint64_t) {
+    reduce();
+    _cwnd = _ssthresh;
+}
+
+void Cubic::on_rto(const size_t, const uint64_t) {
+    reduce();
+    _cwnd = 1;
+}
@@ -0,0 +1,101 @@
+#ifndef SPONGE_LIBSPONGE_TCP_CONGESTION_CONTROL_HH
+#define SPONGE_LIBSPONGE_TCP_CONGESTION_CONTROL_HH
+
+#include "tcp_config.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+//! \brief Interface of a congestion control algorithm driven by the TCPSender
+
+//! The TCPSender never sends past min(receiver window, cwnd()). It reports every
+//! acknowledgment of new data and every loss to the controller, which adjusts the
+//! congestion window and the slow start threshold in response. All windows are in
+//! bytes (sequence space), and all times are in milliseconds on the sender's clock.
+class CongestionController {
+  public:
+    virtual ~CongestionController() = default;
+
+    //! \brief Congestion window, in bytes
+    virtual size_t cwnd() const = 0;
+
+    //! \brief Slow start threshold, in bytes
+    virtual size_t ssthresh() const = 0;
+
+    //! \brief An acknowledgment covered `acked_bytes` previously unacknowledged sequence numbers
+    //! \param[in] acked_bytes number of newly acknowledged sequence numbers
+    //! \param[in] now_ms the sender's clock when the acknowledgment arrived
+    virtual void on_ack(const size_t acked_bytes, const uint64_t now_ms) = 0;
+
+    //! \brief A loss was inferred without the retransmission timer expiring (e.g. by duplicate ACKs)
+    //! \param[in] bytes_in_flight number of sequence numbers outstanding when the loss was detected
+    //! \param[in] now_ms the sender's clock when the loss was detected
+    virtual void on_loss(const size_t bytes_in_flight, const uint64_t now_ms) = 0;
+
+    //! \brief The retransmission timer expired
+    //! \param[in] bytes_in_flight number of sequence numbers outstanding when the timer expired
+    //! \param[in] now_ms the sender's clock when the timer expired
+    virtual void on_rto(const size_t bytes_in_flight, const uint64_t now_ms) = 0;
+
+    //! \brief Create the controller for `algorithm`, or nullptr for TCPConfig::CongestionControl::NONE
+    static std::unique_ptr<CongestionController> make(const TCPConfig::CongestionControl algorithm,
+                                                      const size_t mss = TCPConfig::MAX_PAYLOAD_SIZE);
+};
+
+//! \brief Reno congestion control (\ref rfc::rfc5681 "RFC 5681"): slow start, then one MSS per RTT
+class NewReno : public CongestionController {
+  private:
+    size_t _mss;                    //!< Sender maximum segment size
+    size_t _cwnd;                   //!< Congestion window
+    size_t _ssthresh;               //!< Slow start threshold
+    size_t _acked_in_avoidance{0};  //!< Bytes acknowledged since cwnd last grew during congestion avoidance
+
+  public:
+    //! \param[in] mss the sender maximum segment size
+    explicit NewReno(const size_t mss);
+
+    size_t cwnd() const override { return _cwnd; }
+    size_t ssthresh() const override { return _ssthresh; }
+
+    void on_ack(const size_t acked_bytes, const uint64_t now_ms) override;
+    void on_loss(const size_t bytes_in_flight, const uint64_t now_ms) override;
+    void on_rto(const size_t bytes_in_flight, const uint64_t now_ms) override;
+};
+
+//! \brief CUBIC congestion control (\ref rfc::rfc8312 "RFC 8312")
+
+//! Outside slow start, the window follows W(t) = C*(t-K)^3 + W_max, measured in segments
+//! from the start of the current congestion avoidance epoch, and never grows slower than
+//! the Reno-friendly estimate of the same epoch.
+class Cubic : public CongestionController {
+  private:
+    static constexpr double C = 0.4;     //!< Scaling constant of the cubic function
+    static constexpr double BETA = 0.7;  //!< Multiplicative decrease factor
+
+    double _mss;                 //!< Sender maximum segment size
+    double _cwnd;                //!< Congestion window, in segments
+    double _ssthresh;            //!< Slow start threshold, in segments
+    double _w_max{0};            //!< Window just before the last reduction, in segments
+    double _w_origin{0};         //!< Plateau of the cubic function for the current epoch, in segments
+    double _k{0};                //!< Seconds from the start of the epoch until W(t) reaches `_w_origin`
+    double _w_est{0};            //!< Reno-friendly window estimate, in segments
+    bool _epoch_started{false};  //!< Has the current congestion avoidance epoch begun?
+    uint64_t _epoch_start{0};    //!< Time of the first acknowledgment of the current epoch
+
+    //! Reduce the window after a congestion event, and end the current epoch
+    void reduce();
+
+  public:
+    //! \param[in] mss the sender maximum segment size
+    explicit Cubic(const size_t mss);
+
+    size_t cwnd() const override;
+    size_t ssthresh() const override;
+
+    void on_ack(const size_t acked_bytes, const uint64_t now_ms) override;
+    void on_loss(const size_t bytes_in_flight, const uint64_t now_ms) override;
+    void on_rto(const size_t bytes_in_flight, const uint64_t now_ms) override;
+};
+
+#endif  // SPONGE_LIBSPONGE_TCP_CONGESTION_CONTROL_HH
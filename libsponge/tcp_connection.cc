@@ -1,6 +1,8 @@
 #include "tcp_connection.hh"
 
+#include <algorithm>
 #include <iostream>
+#include <limits>
 
 // Dummy implementation of a TCP connection
 
@@ -32,7 +34,18 @@ bool TCPConnection::real_send() {
     return isSend;
 }
 
-void TCPConnection::segment_received(const TCPSegment &seg) {
+void TCPConnection::segment_received(const TCPSegment &seg) { receive(&seg, &seg + 1); }
+
+void TCPConnection::segments_received(const vector<TCPSegment> &run) {
+    if (!run.empty()) {
+        receive(run.data(), run.data() + run.size());
+    }
+}
+
+//! \details The first segment's header stands for the run, except that a PSH would be on the last one.
+void TCPConnection::receive(const TCPSegment *begin, const TCPSegment *end) {
+    const TCPSegment &seg = *begin;
+    const TCPSegment &last = *(end - 1);
     _time_since_last_segment_received_counter = 0;
     // Check if the RST has been set
     if (seg.header().rst) {
@@ -42,8 +55,27 @@ void TCPConnection::segment_received(const TCPSegment &seg) {
         return;
     }
 
-    // Give the segment to reveicer
-    _receiver.segment_received(seg);
+    // PAWS: an old duplicate is dropped, though acknowledged so that the peer learns where we are
+    if (timestamping() && _receiver.is_old_duplicate(seg)) {
+        if (seg.length_in_sequence_space() > 0) {
+            send_ACK();
+        }
+        return;
+    }
+
+    // Give the segments to reveicer, noting whether they arrived in order and moved the ackno
+    const optional<WrappingInt32> ackno_before = _receiver.ackno();
+    const bool had_gap = _receiver.unassembled_bytes() > 0;
+    for (const TCPSegment *it = begin; it != end; it++) {
+        _receiver.segment_received(*it);
+    }
+    const bool in_order = ackno_before.has_value() && seg.header().seqno == ackno_before.value() && !had_gap &&
+                          _receiver.unassembled_bytes() == 0 && _receiver.ackno() != ackno_before;
+
+    // Never send more than the peer can take in one segment, nor more than our own MSS
+    if (seg.header().syn && _receiver.mss().has_value()) {
+        _sender.set_mss(min<size_t>(_cfg.mss.value_or(TCPConfig::MAX_PAYLOAD_SIZE), _receiver.mss().value()));
+    }
 
     // Check if need to linger
     if (check_inbound_ended() && !_sender.stream_in().eof()) {
@@ -52,7 +84,17 @@ void TCPConnection::segment_received(const TCPSegment &seg) {
 
     // Check if the ACK has been set
     if (seg.header().ack) {
-        _sender.ack_received(seg.header().ackno, seg.header().win);
+        // The window of a SYN is never scaled
+        uint64_t window_size = seg.header().win;
+        if (!seg.header().syn && window_scaling()) {
+            window_size <<= _receiver.window_scale().value();
+        }
+        optional<uint32_t> tsecr{};
+        if (seg.header().timestamps.has_value() && timestamping()) {
+            tsecr = seg.header().timestamps->tsecr;
+        }
+        _sender.ack_received(
+            seg.header().ackno, window_size, seg.length_in_sequence_space() == 0, seg.header().sack, tsecr);
         real_send();
     }
 
@@ -61,39 +103,97 @@ void TCPConnection::segment_received(const TCPSegment &seg) {
         // Handle the SYN/ACK case
         _sender.fill_window();
         bool isSend = real_send();
-        // Send at least one ACK message
+        // Send at least one ACK message, unless it may be delayed
         if (!isSend) {
-            _sender.send_empty_segment();
-            TCPSegment ACKSeg = _sender.segments_out().front();
-            _sender.segments_out().pop();
-            set_ack_and_windowsize(ACKSeg);
-            _segments_out.push(ACKSeg);
+            acknowledge(last, in_order);
         }
     }
 }
 
+//! \details An in-order data segment is only counted, until `delack_segments` of them have arrived or
+//! tick() finds the oldest has waited `delack_timeout` ms. Anything else the peer should hear about at once
+//! (RFC 5681 section 4.2): a SYN, FIN or PSH, or a segment that was out of order, a duplicate, or filled a gap.
+void TCPConnection::acknowledge(const TCPSegment &seg, const bool in_order) {
+    const bool urgent = !in_order || seg.header().syn || seg.header().fin || seg.header().psh;
+    if (urgent || _delayed_acks + 1 >= _cfg.delack_segments) {
+        send_ACK();
+    } else {
+        _delayed_acks++;
+    }
+}
+
 void TCPConnection::set_ack_and_windowsize(TCPSegment &seg) {
-    // Ask receiver for ack and window size
+    // Ask receiver for ack and window size; any segment carrying the ackno settles delayed acknowledgments
     optional<WrappingInt32> ackno = _receiver.ackno();
     if (ackno.has_value()) {
         seg.header().ack = true;
         seg.header().ackno = ackno.value();
+        _delayed_acks = 0;
+        _delayed_ack_time = 0;
     }
 
+    // Outside a SYN the window is scaled down once both sides agreed; either way it saturates rather than wraps
     size_t window_size = _receiver.window_size();
-    seg.header().win = static_cast<uint16_t>(window_size);
+    if (!seg.header().syn && window_scaling()) {
+        window_size >>= _window_scale;
+    }
+    seg.header().win = static_cast<uint16_t>(min<size_t>(window_size, numeric_limits<uint16_t>::max()));
+
+    // Announce our MSS on our SYN
+    if (_cfg.mss.has_value() && seg.header().syn) {
+        seg.header().mss = _cfg.mss;
+    }
+
+    // Offer window scaling on our SYN (on a SYN/ACK, only if the peer offered it too)
+    if (_cfg.window_scaling && seg.header().syn && (!ackno.has_value() || _receiver.window_scale().has_value())) {
+        seg.header().window_scale = _window_scale;
+    }
+
+    // Offer SACK on our SYN (on a SYN/ACK, only if the peer offered it too), and use it once agreed
+    if (_cfg.sack) {
+        if (seg.header().syn) {
+            seg.header().sack_permitted = !ackno.has_value() || _receiver.sack_permitted();
+        } else if (_receiver.sack_permitted()) {
+            seg.header().sack = _receiver.sack_blocks(timestamping() ? TCPHeader::MAX_SACK_BLOCKS_WITH_TIMESTAMPS
+                                                                     : TCPHeader::MAX_SACK_BLOCKS);
+        }
+    }
+
+    // Stamp our SYN (on a SYN/ACK, only if the peer offered timestamps too), and every segment once agreed
+    const bool stamp = seg.header().syn ? !ackno.has_value() || _receiver.timestamps_permitted() : timestamping();
+    if (_cfg.timestamps && stamp) {
+        seg.header().timestamps = TCPTimestamps{_sender.timestamp(), ackno.has_value() ? _receiver.ts_recent() : 0};
+    }
     return;
 }
 
+uint8_t TCPConnection::window_scale_for(const size_t capacity) {
+    uint8_t shift = 0;
+    while (shift < TCPHeader::MAX_WINDOW_SCALE && (capacity >> shift) > numeric_limits<uint16_t>::max()) {
+        shift++;
+    }
+    return shift;
+}
+
+bool TCPConnection::window_scaling() const { return _cfg.window_scaling && _receiver.window_scale().has_value(); }
+
+bool TCPConnection::timestamping() const { return _cfg.timestamps && _receiver.timestamps_permitted(); }
+
 void TCPConnection::connect() {
     _sender.fill_window();
     real_send();
 }
 
 size_t TCPConnection::write(const std::string &data) {
+    return write(Buffer{data.substr(0, remaining_outbound_capacity())});
+}
+
+size_t TCPConnection::write(std::string &&data) { return write(Buffer::compacted(move(data))); }
+
+size_t TCPConnection::write(Buffer data) {
     if (!data.size())
         return 0;
-    size_t actually_write = _sender.stream_in().write(data);
+    size_t actually_write = _sender.stream_in().write(move(data));
     _sender.fill_window();
     real_send();
     return actually_write;
@@ -106,6 +206,25 @@ void TCPConnection::end_input_stream() {
     real_send();
 }
 
+void TCPConnection::uncork() {
+    _sender.uncork();
+    _sender.fill_window();
+    real_send();
+}
+
+void TCPConnection::flush() {
+    _sender.flush();
+    real_send();
+}
+
+void TCPConnection::send_ACK() {
+    _sender.send_empty_segment();
+    TCPSegment ACKSeg = _sender.segments_out().front();
+    _sender.segments_out().pop();
+    set_ack_and_windowsize(ACKSeg);
+    _segments_out.push(ACKSeg);
+}
+
 void TCPConnection::send_RST() {
     _sender.send_empty_segment();
     TCPSegment RSTSeg = _sender.segments_out().front();
@@ -116,14 +235,14 @@ void TCPConnection::send_RST() {
 }
 
 // prereqs1 : The inbound stream has been fully assembled and has ended.
-bool TCPConnection::check_inbound_ended() {
+bool TCPConnection::check_inbound_ended() const {
     return _receiver.unassembled_bytes() == 0 && _receiver.stream_out().input_ended();
 }
 
 // prereqs2 : The outbound stream has been ended by the local application and fully sent (including
 // the fact that it ended, i.e. a segment with fin ) to the remote peer.
 // prereqs3 : The outbound stream has been fully acknowledged by the remote peer.
-bool TCPConnection::check_outbound_ended() {
+bool TCPConnection::check_outbound_ended() const {
     return _sender.stream_in().eof() && _sender.next_seqno_absolute() == _sender.stream_in().bytes_written() + 2 &&
            _sender.bytes_in_flight() == 0;
 }
@@ -131,6 +250,13 @@ bool TCPConnection::check_outbound_ended() {
 //! \param[in] ms_since_last_tick number of milliseconds since the last call to this method
 void TCPConnection::tick(const size_t ms_since_last_tick) {
     _time_since_last_segment_received_counter += ms_since_last_tick;
+    // Send a delayed acknowledgment once it has waited long enough
+    if (_delayed_acks > 0) {
+        _delayed_ack_time += ms_since_last_tick;
+        if (_delayed_ack_time >= _cfg.delack_timeout) {
+            send_ACK();
+        }
+    }
     // Tick the sender to do the retransmit
     _sender.tick(ms_since_last_tick);
     if (_sender.segments_out().size() > 0) {
@@ -146,6 +272,10 @@ void TCPConnection::tick(const size_t ms_since_last_tick) {
         }
         _segments_out.push(retxSeg);
     }
+    // Send whatever pacing released
+    if (_active) {
+        real_send();
+    }
 
     if (check_inbound_ended() && check_outbound_ended()) {
         if (!_linger_after_streams_finish) {
@@ -156,6 +286,26 @@ void TCPConnection::tick(const size_t ms_since_last_tick) {
     }
 }
 
+//! \details The earliest of the sender's timers, the delayed acknowledgment, and the end of
+//! lingering after both streams have finished.
+optional<size_t> TCPConnection::time_until_next_timer() const {
+    if (!_active) {
+        return {};
+    }
+
+    optional<size_t> next = _sender.time_until_next_timer();
+    const auto at_most = [&next](const size_t ms) { next = next.has_value() ? min(next.value(), ms) : ms; };
+    if (_delayed_acks > 0) {
+        at_most(_cfg.delack_timeout > _delayed_ack_time ? _cfg.delack_timeout - _delayed_ack_time : 0);
+    }
+    if (check_inbound_ended() && check_outbound_ended()) {
+        const size_t linger = _linger_after_streams_finish ? 10 * _cfg.rt_timeout : 0;
+        const size_t lingered = _time_since_last_segment_received_counter;
+        at_most(linger > lingered ? linger - lingered : 0);
+    }
+    return next;
+}
+
 TCPConnection::~TCPConnection() {
     try {
         if (active()) {
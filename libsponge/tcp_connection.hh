@@ -11,7 +11,7 @@ class TCPConnection {
   private:
     TCPConfig _cfg;
     TCPReceiver _receiver{_cfg.recv_capacity};
-    TCPSender _sender{_cfg.send_capacity, _cfg.rt_timeout, _cfg.fixed_isn};
+    TCPSender _sender{_cfg};
 
     //! outbound queue of segments that the TCPConnection wants sent
     std::queue<TCPSegment> _segments_out{};
@@ -25,15 +25,34 @@ class TCPConnection {
 
     bool _active{true};
 
+    unsigned _delayed_acks{0};    //!< Data segments received since we last sent an acknowledgment
+    size_t _delayed_ack_time{0};  //!< Milliseconds since the oldest of those segments arrived
+
+    //! Window scale shift count offered on our SYN (\ref rfc::rfc7323 "RFC 7323")
+    uint8_t _window_scale{window_scale_for(_cfg.recv_capacity)};
+
+    //! The smallest window scale shift count that lets `capacity` be advertised in the 16-bit window field
+    static uint8_t window_scale_for(const size_t capacity);
+    //! Did both SYNs carry the window scale option, so that windows outside a SYN are scaled?
+    bool window_scaling() const;
+    //! Did both SYNs carry the timestamps option, so that every segment carries it?
+    bool timestamping() const;
+
+    //! Handle the segments in [begin, end), whose headers match apart from the seqno, as one segment
+    void receive(const TCPSegment *begin, const TCPSegment *end);
+
     void send_RST();
+    void send_ACK();
+    //! Acknowledge a segment that occupied sequence space, now or later under the delayed-ACK policy
+    void acknowledge(const TCPSegment &seg, const bool in_order);
     bool real_send();
     void set_ack_and_windowsize(TCPSegment &segment);
     // prereqs1 : The inbound stream has been fully assembled and has ended.
-    bool check_inbound_ended();
+    bool check_inbound_ended() const;
     // prereqs2 : The outbound stream has been ended by the local application and fully sent (including
     // the fact that it ended, i.e. a segment with fin ) to the remote peer.
     // prereqs3 : The outbound stream has been fully acknowledged by the remote peer.
-    bool check_outbound_ended();
+    bool check_outbound_ended() const;
 
   public:
     //! \name "Input" interface for the writer
@@ -46,11 +65,30 @@ class TCPConnection {
     //! \returns the number of bytes from `data` that were actually written.
     size_t write(const std::string &data);
 
+    //! \brief Write data to the outbound byte stream, taking ownership of its storage
+    //! \details The storage is first shrunk if it is mostly spare (see Buffer::compacted()), so that a short
+    //! read into a large buffer doesn't keep the whole buffer alive while its bytes are queued or in flight.
+    //! \returns the number of bytes from `data` that were actually written.
+    size_t write(std::string &&data);
+
+    //! \brief Write a Buffer to the outbound byte stream without copying it
+    //! \returns the number of bytes from `data` that were actually written.
+    size_t write(Buffer data);
+
     //! \returns the number of `bytes` that can be written right now.
     size_t remaining_outbound_capacity() const;
 
     //! \brief Shut down the outbound byte stream (still allows reading incoming data)
     void end_input_stream();
+
+    //! \brief Send only full segments until uncork(), so that many small writes share segments
+    void cork() { _sender.cork(); }
+
+    //! \brief Stop corking, and send what the cork held back
+    void uncork();
+
+    //! \brief Send everything written so far, even what Nagle's algorithm (TCPConfig::nagle) or a cork holds back
+    void flush();
     //!@}
 
     //! \name "Output" interface for the reader
@@ -79,15 +117,30 @@ class TCPConnection {
     //! Called when a new segment has been received from the network
     void segment_received(const TCPSegment &seg);
 
+    //! \brief Called with a run of segments from TCPSegment::coalesce(), which is handled as one segment
+    //! \details Each payload goes to the reassembler as it is, while the rest of the work (including any ACK)
+    //! is done once for the run.
+    void segments_received(const std::vector<TCPSegment> &run);
+
     //! Called periodically when time elapses
     void tick(const size_t ms_since_last_tick);
 
+    //! \brief Milliseconds until tick() has something to do, or nothing if no timer is pending
+    //! \details An owner with many connections can tick each one only when this much time has passed
+    //! (or just before handing it a segment), instead of ticking all of them periodically.
+    std::optional<size_t> time_until_next_timer() const;
+
     //! \brief TCPSegments that the TCPConnection has enqueued for transmission.
     //! \note The owner or operating system will dequeue these and
     //! put each one into the payload of a lower-layer datagram (usually Internet datagrams (IP),
     //! but could also be user datagrams (UDP) or any other kind).
     std::queue<TCPSegment> &segments_out() { return _segments_out; }
 
+    //! \brief Largest payload of a segment on the wire
+    //! \note With TCPConfig::gso_segments above one, segments_out() may hold larger segments, which the
+    //! owner splits with TCPSegment::split() just before they are sent.
+    size_t mss() const { return _sender.mss(); }
+
     //! \brief Is the connection still alive in any way?
     //! \returns `true` if either stream is still running or if the TCPConnection is lingering
     //! after both streams have finished (e.g. to ACK retransmissions from the peer)
@@ -6,6 +6,24 @@
 
 using namespace std;
 
+string FourTuple::to_string() const {
+    return Address::from_ipv4_numeric(local_ip, local_port).to_string() + " <- " +
+           Address::from_ipv4_numeric(remote_ip, remote_port).to_string();
+}
+
+//! \details Mixes all four fields (with the finalizer of MurmurHash3), so that connections
+//! that differ only in a port still spread evenly over the buckets.
+size_t FourTupleHash::operator()(const FourTuple &tuple) const {
+    uint64_t h = (uint64_t{tuple.local_ip} << 32 | tuple.remote_ip) ^
+                 ((uint64_t{tuple.local_port} << 16 | tuple.remote_port) * 0x9e3779b97f4a7c15ULL);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
 //! \details This function first attempts to parse a TCP segment from the next UDP
 //! payload recv()d from the socket.
 //!
@@ -18,17 +36,29 @@ using namespace std;
 //! `_listen` flag and calls calls connect() on the underlying UDP socket, with
 //! the result that future outgoing segments go to the sender of the SYN segment.
 //! \returns a std::optional<TCPSegment> that is empty if the segment was invalid or unrelated
-optional<TCPSegment> TCPOverUDPSocketAdapter::read() {
-    auto datagram = _sock.recv();
+optional<TCPSegment> TCPOverUDPSocketAdapter::read() { return unwrap_tcp_in_udp(_sock.recv()); }
 
+//! \details The socket stays blocking (so that write() can wait for room); the read alone doesn't wait.
+bool TCPOverUDPSocketAdapter::try_read(optional<TCPSegment> &segment) {
+    UDPSocket::received_datagram datagram{{nullptr, 0}, ""};
+    if (not _sock.try_recv(datagram)) {
+        return false;
+    }
+    segment = unwrap_tcp_in_udp(move(datagram));
+    return true;
+}
+
+//! \param[in] datagram is the UDP datagram just received
+//! \returns a std::optional<TCPSegment> that is empty if the segment was invalid or unrelated
+optional<TCPSegment> TCPOverUDPSocketAdapter::unwrap_tcp_in_udp(UDPSocket::received_datagram &&datagram) {
     // is it for us?
     if (not listening() and (datagram.source_address != config().destination)) {
         return {};
     }
 
-    // is the payload a valid TCP segment?
+    // is the payload a valid TCP segment? (the segment's payload keeps the datagram's storage alive)
     TCPSegment seg;
-    if (ParseResult::NoError != seg.parse(move(datagram.payload), 0)) {
+    if (ParseResult::NoError != seg.parse(Buffer::compacted(move(datagram.payload)), 0)) {
         return {};
     }
 
@@ -53,5 +83,42 @@ void TCPOverUDPSocketAdapter::write(TCPSegment &seg) {
     _sock.sendto(config().destination, seg.serialize(0));
 }
 
+TCPOverUDPMuxAdapter::TCPOverUDPMuxAdapter(UDPSocket &&sock)
+    : _sock(move(sock)), _local_ip(_sock.local_address().ipv4_numeric()) {}
+
+//! \returns a std::optional<DemuxedSegment> that is empty if the payload was not a valid TCP segment
+optional<DemuxedSegment> TCPOverUDPMuxAdapter::read() { return demux_tcp_in_udp(_sock.recv()); }
+
+//! \details Like TCPOverUDPSocketAdapter::try_read(), this leaves the socket blocking for write().
+bool TCPOverUDPMuxAdapter::try_read(optional<DemuxedSegment> &demuxed) {
+    UDPSocket::received_datagram datagram{{nullptr, 0}, ""};
+    if (not _sock.try_recv(datagram)) {
+        return false;
+    }
+    demuxed = demux_tcp_in_udp(move(datagram));
+    return true;
+}
+
+//! \param[in] datagram is the UDP datagram just received
+//! \returns a std::optional<DemuxedSegment> that is empty if the payload was not a valid TCP segment
+optional<DemuxedSegment> TCPOverUDPMuxAdapter::demux_tcp_in_udp(UDPSocket::received_datagram &&datagram) const {
+    TCPSegment seg;
+    if (ParseResult::NoError != seg.parse(Buffer::compacted(move(datagram.payload)), 0)) {
+        return {};
+    }
+
+    const FourTuple tuple{_local_ip, seg.header().dport, datagram.source_address.ipv4_numeric(), seg.header().sport};
+    return DemuxedSegment{tuple, move(datagram.source_address), move(seg)};
+}
+
+//! \param[in] peer is the UDP address of the remote endpoint
+//! \param[in] tuple is the connection that `seg` belongs to
+//! \param[in] seg is the TCP segment to write
+void TCPOverUDPMuxAdapter::write(const Address &peer, const FourTuple &tuple, TCPSegment &seg) {
+    seg.header().sport = tuple.local_port;
+    seg.header().dport = tuple.remote_port;
+    _sock.sendto(peer, seg.serialize(0));
+}
+
 //! Specialize LossyFdAdapter to TCPOverUDPSocketAdapter
 template class LossyFdAdapter<TCPOverUDPSocketAdapter>;
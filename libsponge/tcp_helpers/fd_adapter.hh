@@ -8,9 +8,42 @@
 #include "tcp_header.hh"
 #include "tcp_segment.hh"
 
+#include <cstddef>
+#include <cstdint>
 #include <optional>
+#include <string>
 #include <utility>
 
+//! \brief Identifies a TCP connection by the addresses and ports of both of its endpoints
+//! \details Addresses are IPv4 addresses in host byte order; ports are the TCP ports.
+struct FourTuple {
+    uint32_t local_ip{0};     //!< Address of the local endpoint
+    uint16_t local_port{0};   //!< Port of the local endpoint
+    uint32_t remote_ip{0};    //!< Address of the remote endpoint
+    uint16_t remote_port{0};  //!< Port of the remote endpoint
+
+    bool operator==(const FourTuple &other) const {
+        return local_ip == other.local_ip and local_port == other.local_port and remote_ip == other.remote_ip and
+               remote_port == other.remote_port;
+    }
+    bool operator!=(const FourTuple &other) const { return not operator==(other); }
+
+    //! Human-readable string, e.g., "10.0.0.1:80 <- 10.0.0.2:51000"
+    std::string to_string() const;
+};
+
+//! \brief Hash of a FourTuple, so that it can key an unordered container
+struct FourTupleHash {
+    size_t operator()(const FourTuple &tuple) const;
+};
+
+//! \brief A TCP segment read by a multiplexing adapter, with the connection it belongs to
+struct DemuxedSegment {
+    FourTuple tuple;     //!< The connection (local = destination of the segment, remote = its source)
+    Address peer;        //!< Where the adapter sends replies on this connection (e.g., the UDP source address)
+    TCPSegment segment;  //!< The segment itself
+};
+
 //! \brief Basic functionality for file descriptor adaptors
 //! \details See TCPOverUDPSocketAdapter and TCPOverIPv4OverTunFdAdapter for more information.
 class FdAdapterBase {
@@ -47,6 +80,9 @@ class TCPOverUDPSocketAdapter : public FdAdapterBase {
   private:
     UDPSocket _sock;
 
+    //! The TCP segment in a received datagram, if it is valid and related to the current connection
+    std::optional<TCPSegment> unwrap_tcp_in_udp(UDPSocket::received_datagram &&datagram);
+
   public:
     //! Construct from a UDPSocket sliced into a FileDescriptor
     explicit TCPOverUDPSocketAdapter(UDPSocket &&sock) : _sock(std::move(sock)) {}
@@ -54,6 +90,10 @@ class TCPOverUDPSocketAdapter : public FdAdapterBase {
     //! Attempts to read and return a TCP segment related to the current connection from a UDP payload
     std::optional<TCPSegment> read();
 
+    //! \brief Like read(), but only if a datagram is waiting
+    //! \returns `false` if no datagram was waiting; otherwise `segment` holds what read() would have returned
+    bool try_read(std::optional<TCPSegment> &segment);
+
     //! Writes a TCP segment into a UDP payload
     void write(TCPSegment &seg);
 
@@ -67,4 +107,41 @@ class TCPOverUDPSocketAdapter : public FdAdapterBase {
 //! Typedef for TCPOverUDPSocketAdapter
 using LossyTCPOverUDPSocketAdapter = LossyFdAdapter<TCPOverUDPSocketAdapter>;
 
+//! \brief A FD adaptor that carries the TCP segments of many connections in the UDP payloads of one socket
+//! \details Unlike TCPOverUDPSocketAdapter, it does not filter what it reads: each segment is returned
+//! with its FourTuple, whose local address is the socket's, whose remote address is the UDP source's,
+//! and whose ports are the TCP ports. Replies go to the UDP source, so one socket serves any number
+//! of peers and TCP ports.
+class TCPOverUDPMuxAdapter {
+  private:
+    UDPSocket _sock;
+    uint32_t _local_ip;
+
+    //! The TCP segment in a received datagram, and its connection, if the payload is a valid segment
+    std::optional<DemuxedSegment> demux_tcp_in_udp(UDPSocket::received_datagram &&datagram) const;
+
+  public:
+    //! Construct from a bound UDPSocket
+    explicit TCPOverUDPMuxAdapter(UDPSocket &&sock);
+
+    //! Attempts to read and return a TCP segment, and the connection it belongs to, from a UDP payload
+    std::optional<DemuxedSegment> read();
+
+    //! \brief Like read(), but only if a datagram is waiting
+    //! \returns `false` if no datagram was waiting; otherwise `demuxed` holds what read() would have returned
+    bool try_read(std::optional<DemuxedSegment> &demuxed);
+
+    //! Writes a TCP segment of connection `tuple` into a UDP payload sent to `peer`
+    void write(const Address &peer, const FourTuple &tuple, TCPSegment &seg);
+
+    //! Address of the local endpoint of every connection
+    uint32_t local_ip() const { return _local_ip; }
+
+    //! Access the underlying UDP socket
+    operator UDPSocket &() { return _sock; }
+
+    //! Access the underlying UDP socket
+    operator const UDPSocket &() const { return _sock; }
+};
+
 #endif  // SPONGE_LIBSPONGE_FD_ADAPTER_HH
@@ -47,6 +47,18 @@ class LossyFdAdapter {
         return ret;
     }
 
+    //! \brief Read from the underlying AdapterT instance if a datagram is waiting, potentially dropping it
+    //! \returns `false` if no datagram was waiting; otherwise `segment` holds what read() would have returned
+    bool try_read(std::optional<TCPSegment> &segment) {
+        if (not _adapter.try_read(segment)) {
+            return false;
+        }
+        if (_should_drop(false)) {
+            segment.reset();
+        }
+        return true;
+    }
+
     //! \brief Write to the underlying AdapterT instance, potentially dropping the datagram to be written
     //! \param[in] seg is the packet to either write or drop
     void write(TCPSegment &seg) {
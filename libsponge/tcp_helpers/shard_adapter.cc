@@ -0,0 +1,40 @@
+#include "shard_adapter.hh"
+
+#include "util.hh"
+
+#include <string>
+#include <sys/eventfd.h>
+
+using namespace std;
+
+ShardAdapter::Inbox::Inbox(const size_t capacity)
+    : _queue(capacity), _signal(SystemCall("eventfd", ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK))) {}
+
+void ShardAdapter::Inbox::notify() {
+    const uint64_t one = 1;
+    _signal.write(string(reinterpret_cast<const char *>(&one), sizeof(one)));
+}
+
+//! \details Clears the signal before taking the segments, so that a segment pushed meanwhile
+//! is either taken now or signaled again by the dispatcher's next notify().
+void ShardAdapter::Inbox::take_all(deque<DemuxedSegment> &taken) {
+    string count;
+    _signal.try_read(count, sizeof(uint64_t));
+    while (auto demuxed = _queue.pop()) {
+        taken.push_back(move(demuxed.value()));
+    }
+}
+
+//! \returns a std::optional<DemuxedSegment> that is empty if the inbox was empty after all
+optional<DemuxedSegment> ShardAdapter::read() {
+    if (_taken.empty()) {
+        _inbox->take_all(_taken);
+        if (_taken.empty()) {
+            return {};
+        }
+    }
+
+    DemuxedSegment demuxed = move(_taken.front());
+    _taken.pop_front();
+    return demuxed;
+}
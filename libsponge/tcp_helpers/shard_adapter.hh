@@ -0,0 +1,82 @@
+#ifndef SPONGE_LIBSPONGE_SHARD_ADAPTER_HH
+#define SPONGE_LIBSPONGE_SHARD_ADAPTER_HH
+
+#include "fd_adapter.hh"
+#include "file_descriptor.hh"
+#include "spsc_queue.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <utility>
+
+//! \brief The adapter of one shard of a ShardedTCPStack
+//! \details The ShardedTCPStack's dispatcher thread reads each segment from the real adapter and
+//! hands it to the shard that its FourTuple hashes to, through the shard's Inbox. The shard writes
+//! its own segments straight to the real adapter, through a Writer.
+class ShardAdapter {
+  public:
+    //! Segments on their way from the dispatcher thread to one shard
+    class Inbox {
+      private:
+        SPSCQueue<DemuxedSegment> _queue;  //!< Segments pushed and not yet taken
+        FileDescriptor _signal;            //!< A non-blocking eventfd, readable after notify() until take_all()
+
+      public:
+        //! \param[in] capacity is the most segments that may wait for the shard
+        explicit Inbox(const size_t capacity);
+
+        //! \brief Hand a segment to the shard (dispatcher only)
+        //! \returns false if the inbox is full, in which case the segment is dropped
+        bool push(DemuxedSegment &&demuxed) { return _queue.push(std::move(demuxed)); }
+
+        //! \brief Wake the shard to take the segments pushed so far (dispatcher only)
+        void notify();
+
+        //! \brief Take every segment pushed so far, and clear the signal (shard only)
+        void take_all(std::deque<DemuxedSegment> &taken);
+
+        //! The eventfd that the shard waits on
+        const FileDescriptor &signal() const { return _signal; }
+    };
+
+    //! Writes a segment of a connection to the real adapter
+    using Writer = std::function<void(const Address &peer, const FourTuple &tuple, TCPSegment &seg)>;
+
+  private:
+    std::shared_ptr<Inbox> _inbox;
+    Writer _writer;
+    uint32_t _local_ip;
+    std::deque<DemuxedSegment> _taken{};  //!< Segments taken from the inbox and not yet read
+
+  public:
+    //! \param[in] inbox is where the dispatcher puts this shard's segments
+    //! \param[in] writer writes this shard's segments to the real adapter
+    //! \param[in] local_ip is the address of the local endpoint of every connection
+    ShardAdapter(std::shared_ptr<Inbox> inbox, Writer writer, const uint32_t local_ip)
+        : _inbox(std::move(inbox)), _writer(std::move(writer)), _local_ip(local_ip) {}
+
+    //! Returns the next segment, first taking every segment waiting in the inbox if none is left
+    std::optional<DemuxedSegment> read();
+
+    //! \brief Like read(), which never waits either
+    //! \returns `false` if no segment was waiting; otherwise `demuxed` holds the next one
+    bool try_read(std::optional<DemuxedSegment> &demuxed) {
+        demuxed = read();
+        return demuxed.has_value();
+    }
+
+    //! Writes a TCP segment of connection `tuple` to the real adapter
+    void write(const Address &peer, const FourTuple &tuple, TCPSegment &seg) { _writer(peer, tuple, seg); }
+
+    //! Address of the local endpoint of every connection
+    uint32_t local_ip() const { return _local_ip; }
+
+    //! Access the eventfd that signals new segments in the inbox
+    operator const FileDescriptor &() const { return _inbox->signal(); }
+};
+
+#endif  // SPONGE_LIBSPONGE_SHARD_ADAPTER_HH
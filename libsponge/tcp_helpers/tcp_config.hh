@@ -11,15 +11,64 @@
 //! Config for TCP sender and receiver
 class TCPConfig {
   public:
-    static constexpr size_t DEFAULT_CAPACITY = 64000;  //!< Default capacity
-    static constexpr size_t MAX_PAYLOAD_SIZE = 1000;   //!< Conservative max payload size for real Internet
-    static constexpr uint16_t TIMEOUT_DFLT = 1000;     //!< Default re-transmit timeout is 1 second
-    static constexpr unsigned MAX_RETX_ATTEMPTS = 8;   //!< Maximum re-transmit attempts before giving up
+    static constexpr size_t DEFAULT_CAPACITY = 64000;    //!< Default capacity
+    static constexpr size_t MAX_PAYLOAD_SIZE = 1000;     //!< Conservative max payload size for real Internet
+    static constexpr uint16_t TIMEOUT_DFLT = 1000;       //!< Default re-transmit timeout is 1 second
+    static constexpr unsigned MAX_RETX_ATTEMPTS = 8;     //!< Maximum re-transmit attempts before giving up
+    static constexpr uint16_t RTO_MIN_DFLT = 200;        //!< Default lower bound on an estimated re-transmit timeout
+    static constexpr uint16_t RTO_MAX_DFLT = 60000;      //!< Default upper bound on an estimated re-transmit timeout
+    static constexpr uint16_t DELACK_TIMEOUT_DFLT = 40;  //!< Default longest delay of an acknowledgment
+
+    //! Congestion control algorithms the TCPSender can use
+    enum class CongestionControl {
+        NONE,     //!< Send up to the receiver's window
+        NEWRENO,  //!< Reno slow start and congestion avoidance (RFC 5681)
+        CUBIC     //!< CUBIC window growth (RFC 8312)
+    };
 
     uint16_t rt_timeout = TIMEOUT_DFLT;       //!< Initial value of the retransmission timeout, in milliseconds
     size_t recv_capacity = DEFAULT_CAPACITY;  //!< Receive capacity, in bytes
     size_t send_capacity = DEFAULT_CAPACITY;  //!< Sender capacity, in bytes
     std::optional<WrappingInt32> fixed_isn{};
+
+    CongestionControl congestion_control = CongestionControl::NONE;  //!< Congestion control used by the sender
+
+    //! Retransmit the oldest outstanding segment on the third duplicate ACK (RFC 5681, section 3.2) rather than
+    //! waiting for the timer. Always on with congestion control, which also shrinks the window on each loss.
+    bool fast_retransmit = false;
+
+    bool adaptive_rto = false;        //!< Derive the retransmission timeout from RTT samples (RFC 6298)
+    uint16_t rto_min = RTO_MIN_DFLT;  //!< Lower bound on the estimated retransmission timeout, in milliseconds
+    uint16_t rto_max = RTO_MAX_DFLT;  //!< Upper bound on the retransmission timeout when adaptive, in milliseconds
+
+    bool sack = false;  //!< Offer selective acknowledgments (RFC 2018), and send them if the peer agrees
+
+    //! Offer window scaling (RFC 7323), so that a `recv_capacity` above 64 KiB can be advertised in full
+    bool window_scaling = false;
+
+    //! Offer timestamps (RFC 7323) to time every acknowledgment and to reject old duplicate segments (PAWS)
+    bool timestamps = false;
+
+    //! Maximum segment size to announce on our SYN, which also caps the segments we send. They grow past
+    //! MAX_PAYLOAD_SIZE only if the peer announces an MSS that large; a smaller MSS from the peer is obeyed.
+    std::optional<uint16_t> mss{};
+
+    //! Most MSS-sized segments the sender packs into one, leaving TCPSegment::split() to the adapter (GSO)
+    unsigned gso_segments = 1;
+
+    //! Acknowledge every `delack_segments` data segments (RFC 1122 suggests 2; more gives stretch ACKs).
+    //! Out-of-order, duplicate, PSH and FIN segments are still acknowledged at once; 1 acknowledges all at once.
+    unsigned delack_segments = 1;
+    uint16_t delack_timeout = DELACK_TIMEOUT_DFLT;  //!< Longest an acknowledgment may be delayed, in milliseconds
+
+    //! Hold back a segment smaller than the MSS while data is unacknowledged (Nagle, RFC 896). Against a peer
+    //! that delays ACKs this can stall each small write by the peer's delack timeout; flush() sends at once.
+    bool nagle = false;
+
+    //! Pace new data through a credit that tick() refills, rather than sending the whole window at once:
+    //! at `pacing_rate` bytes per second if set, or else at a rate derived from the window and the SRTT
+    bool pacing = false;
+    std::optional<uint64_t> pacing_rate{};
 };
 
 //! Config for classes derived from FdAdapter
@@ -1,9 +1,136 @@
 #include "tcp_header.hh"
 
+#include <algorithm>
 #include <sstream>
 
 using namespace std;
 
+//! Kinds of the TCP options that are understood
+enum TCPOptionKind : uint8_t {
+    END_OF_OPTIONS = 0,  //!< End of option list (\ref rfc::rfc793 "RFC 793")
+    NO_OPERATION = 1,    //!< Padding (\ref rfc::rfc793 "RFC 793")
+    MSS = 2,             //!< Maximum segment size (\ref rfc::rfc793 "RFC 793")
+    WINDOW_SCALE = 3,    //!< Window scale (\ref rfc::rfc7323 "RFC 7323")
+    SACK_PERMITTED = 4,  //!< SACK-permitted (\ref rfc::rfc2018 "RFC 2018")
+    SACK = 5,            //!< SACK (\ref rfc::rfc2018 "RFC 2018")
+    TIMESTAMPS = 8       //!< Timestamps (\ref rfc::rfc7323 "RFC 7323")
+};
+
+//! \param[in,out] header the header whose option fields are set
+//! \param[in] p a NetParser holding exactly the header's options
+//! \details Unknown options are skipped. A malformed option ends the option list, as if the
+//! remaining bytes were padding, rather than failing the whole segment.
+static void parse_options(TCPHeader &header, NetParser p) {
+    header.mss.reset();
+    header.window_scale.reset();
+    header.timestamps.reset();
+    header.sack_permitted = false;
+    header.sack.clear();
+
+    while (p.buffer().size() > 0) {
+        const uint8_t kind = p.u8();
+        if (kind == END_OF_OPTIONS) {
+            break;
+        }
+        if (kind == NO_OPERATION) {
+            continue;
+        }
+
+        const uint8_t length = p.u8();
+        if (p.error() or length < 2 or length - 2u > p.buffer().size()) {
+            break;
+        }
+        Buffer body = p.buffer();
+        body.remove_suffix(body.size() - (length - 2u));
+        p.remove_prefix(length - 2u);
+
+        NetParser option{body};
+        switch (kind) {
+            case MSS:
+                header.mss = option.u16();
+                if (option.error()) {
+                    header.mss.reset();
+                }
+                break;
+            case WINDOW_SCALE:
+                header.window_scale = option.u8();
+                if (option.error()) {
+                    header.window_scale.reset();
+                }
+                break;
+            case TIMESTAMPS: {
+                const uint32_t tsval = option.u32();
+                const uint32_t tsecr = option.u32();
+                if (not option.error()) {
+                    header.timestamps = TCPTimestamps{tsval, tsecr};
+                }
+                break;
+            }
+            case SACK_PERMITTED:
+                header.sack_permitted = true;
+                break;
+            case SACK:
+                while (option.buffer().size() >= 8 and header.sack.size() < TCPHeader::MAX_SACK_BLOCKS) {
+                    const WrappingInt32 left{option.u32()};
+                    const WrappingInt32 right{option.u32()};
+                    header.sack.push_back({left, right});
+                }
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+//! \param[in] header the header whose option fields are serialized
+//! \returns the options, not yet padded to a multiple of four bytes
+//! \details SACK goes last, with as many blocks as still fit.
+static string serialize_options(const TCPHeader &header) {
+    string ret;
+
+    if (header.mss.has_value()) {
+        NetUnparser::u8(ret, MSS);
+        NetUnparser::u8(ret, 4);
+        NetUnparser::u16(ret, header.mss.value());
+    }
+
+    if (header.window_scale.has_value()) {
+        NetUnparser::u8(ret, WINDOW_SCALE);
+        NetUnparser::u8(ret, 3);
+        NetUnparser::u8(ret, header.window_scale.value());
+    }
+
+    if (header.timestamps.has_value()) {
+        NetUnparser::u8(ret, TIMESTAMPS);
+        NetUnparser::u8(ret, 10);
+        NetUnparser::u32(ret, header.timestamps->tsval);
+        NetUnparser::u32(ret, header.timestamps->tsecr);
+    }
+
+    if (header.sack_permitted) {
+        NetUnparser::u8(ret, SACK_PERMITTED);
+        NetUnparser::u8(ret, 2);
+    }
+
+    // Each SACK block takes 8 bytes after the option's kind and length
+    const size_t room = TCPHeader::MAX_OPTIONS_LENGTH - 2 - ret.size();
+    const size_t n_blocks = min({header.sack.size(), TCPHeader::MAX_SACK_BLOCKS, room / 8});
+    if (n_blocks > 0) {
+        NetUnparser::u8(ret, SACK);
+        NetUnparser::u8(ret, 2 + 8 * n_blocks);
+        for (size_t i = 0; i < n_blocks; i++) {
+            NetUnparser::u32(ret, header.sack[i].left.raw_value());
+            NetUnparser::u32(ret, header.sack[i].right.raw_value());
+        }
+    }
+
+    if (ret.size() > TCPHeader::MAX_OPTIONS_LENGTH) {
+        throw runtime_error("TCP options too long");
+    }
+
+    return ret;
+}
+
 //! \param[in,out] p is a NetParser from which the TCP fields will be extracted
 //! \returns a ParseResult indicating success or the reason for failure
 //! \details It is important to check for (at least) the following potential errors
@@ -37,31 +164,40 @@ ParseResult TCPHeader::parse(NetParser &p) {
         return ParseResult::HeaderTooShort;
     }
 
-    // skip any options or anything extra in the header
-    p.remove_prefix(doff * 4 - TCPHeader::LENGTH);
+    // parse any options, skipping anything extra in the header
+    const size_t options_length = doff * 4 - TCPHeader::LENGTH;
+    Buffer options = p.buffer();
+    p.remove_prefix(options_length);
 
     if (p.error()) {
         return p.get_error();
     }
 
+    options.remove_suffix(options.size() - options_length);
+    parse_options(*this, options);
+
     return ParseResult::NoError;
 }
 
 //! Serialize the TCPHeader to a string (does not recompute the checksum)
+//! \details The data offset written is the larger of `doff` and the length needed for the options.
 string TCPHeader::serialize() const {
     // sanity check
     if (doff < 5) {
         throw runtime_error("TCP header too short");
     }
 
+    const string options = serialize_options(*this);
+    const uint8_t data_offset = max<size_t>(doff, (LENGTH + options.size() + 3) / 4);
+
     string ret;
-    ret.reserve(4 * doff);
+    ret.reserve(4 * data_offset);
 
     NetUnparser::u16(ret, sport);              // source port
     NetUnparser::u16(ret, dport);              // destination port
     NetUnparser::u32(ret, seqno.raw_value());  // sequence number
     NetUnparser::u32(ret, ackno.raw_value());  // ack number
-    NetUnparser::u8(ret, doff << 4);           // data offset
+    NetUnparser::u8(ret, data_offset << 4);    // data offset
 
     const uint8_t fl_b = (urg ? 0b0010'0000 : 0) | (ack ? 0b0001'0000 : 0) | (psh ? 0b0000'1000 : 0) |
                          (rst ? 0b0000'0100 : 0) | (syn ? 0b0000'0010 : 0) | (fin ? 0b0000'0001 : 0);
@@ -72,7 +208,8 @@ string TCPHeader::serialize() const {
 
     NetUnparser::u16(ret, uptr);  // urgent pointer
 
-    ret.resize(4 * doff);  // expand header to advertised size
+    ret.append(options);          // options
+    ret.resize(4 * data_offset);  // pad header to advertised size with end-of-options
 
     return ret;
 }
@@ -90,13 +227,44 @@ string TCPHeader::to_string() const {
        << "TCP winsize: " << +win << '\n'
        << "TCP cksum: " << +cksum << '\n'
        << "TCP uptr: " << +uptr << '\n';
+    if (mss.has_value()) {
+        ss << "TCP MSS: " << +mss.value() << '\n';
+    }
+    if (window_scale.has_value()) {
+        ss << "TCP window scale: " << +window_scale.value() << '\n';
+    }
+    if (timestamps.has_value()) {
+        ss << "TCP timestamps: TSval " << timestamps->tsval << " TSecr " << timestamps->tsecr << '\n';
+    }
+    if (sack_permitted) {
+        ss << "TCP SACK permitted\n";
+    }
+    for (const auto &block : sack) {
+        ss << "TCP SACK block: " << block.left << '-' << block.right << '\n';
+    }
     return ss.str();
 }
 
 string TCPHeader::summary() const {
     stringstream ss{};
     ss << "Header(flags=" << (syn ? "S" : "") << (ack ? "A" : "") << (rst ? "R" : "") << (fin ? "F" : "")
-       << ",seqno=" << seqno << ",ack=" << ackno << ",win=" << win << ")";
+       << ",seqno=" << seqno << ",ack=" << ackno << ",win=" << win;
+    if (mss.has_value()) {
+        ss << ",mss=" << mss.value();
+    }
+    if (window_scale.has_value()) {
+        ss << ",wscale=" << +window_scale.value();
+    }
+    if (timestamps.has_value()) {
+        ss << ",ts=" << timestamps->tsval << '/' << timestamps->tsecr;
+    }
+    if (not sack.empty()) {
+        ss << ",sack=";
+        for (const auto &block : sack) {
+            ss << (&block == &sack.front() ? "" : " ") << block.left << '-' << block.right;
+        }
+    }
+    ss << ")";
     return ss.str();
 }
 
@@ -104,5 +272,12 @@ bool TCPHeader::operator==(const TCPHeader &other) const {
     // TODO(aozdemir) more complete check (right now we omit cksum, src, dst
     return seqno == other.seqno && ackno == other.ackno && doff == other.doff && urg == other.urg && ack == other.ack &&
            psh == other.psh && rst == other.rst && syn == other.syn && fin == other.fin && win == other.win &&
-           uptr == other.uptr;
+           uptr == other.uptr && mss == other.mss && window_scale == other.window_scale &&
+           timestamps.has_value() == other.timestamps.has_value() &&
+           (not timestamps.has_value() ||
+            (timestamps->tsval == other.timestamps->tsval && timestamps->tsecr == other.timestamps->tsecr)) &&
+           sack_permitted == other.sack_permitted &&
+           equal(sack.begin(), sack.end(), other.sack.begin(), other.sack.end(), [](const auto &a, const auto &b) {
+               return a.left == b.left && a.right == b.right;
+           });
 }
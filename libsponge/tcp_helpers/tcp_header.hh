@@ -4,11 +4,33 @@
 #include "parser.hh"
 #include "wrapping_integers.hh"
 
+#include <optional>
+#include <vector>
+
+//! \brief A block of sequence space, [left, right), held by the receiver (\ref rfc::rfc2018 "RFC 2018")
+struct SACKBlock {
+    WrappingInt32 left;   //!< First sequence number of the block
+    WrappingInt32 right;  //!< Sequence number just past the end of the block
+};
+
+//! \brief The timestamps option (\ref rfc::rfc7323 "RFC 7323")
+struct TCPTimestamps {
+    uint32_t tsval;  //!< Sender's clock when the segment was sent
+    uint32_t tsecr;  //!< Most recent TSval received from the peer, valid only when the ACK flag is set
+};
+
 //! \brief [TCP](\ref rfc::rfc793) segment header
-//! \note TCP options are not supported
+//! \note Of the TCP options, only maximum segment size (\ref rfc::rfc793 "RFC 793"), window scale and
+//! timestamps (\ref rfc::rfc7323 "RFC 7323"), SACK-permitted and SACK (\ref rfc::rfc2018 "RFC 2018") are
+//! supported. Others are skipped when parsing.
 struct TCPHeader {
     static constexpr size_t LENGTH = 20;  //!< [TCP](\ref rfc::rfc793) header length, not including options
 
+    static constexpr size_t MAX_OPTIONS_LENGTH = 40;              //!< Largest amount of options that fits in a header
+    static constexpr size_t MAX_SACK_BLOCKS = 4;                  //!< Most SACK blocks that fit in the options
+    static constexpr size_t MAX_SACK_BLOCKS_WITH_TIMESTAMPS = 3;  //!< Most SACK blocks that fit beside timestamps
+    static constexpr uint8_t MAX_WINDOW_SCALE = 14;               //!< Largest usable window scale shift count
+
     //! \struct TCPHeader
     //! ~~~{.txt}
     //!   0                   1                   2                   3
@@ -38,7 +60,7 @@ struct TCPHeader {
     uint16_t dport = 0;         //!< destination port
     WrappingInt32 seqno{0};     //!< sequence number
     WrappingInt32 ackno{0};     //!< ack number
-    uint8_t doff = LENGTH / 4;  //!< data offset
+    uint8_t doff = LENGTH / 4;  //!< data offset (serialize() grows it to fit the options)
     bool urg = false;           //!< urgent flag
     bool ack = false;           //!< ack flag
     bool psh = false;           //!< push flag
@@ -50,6 +72,15 @@ struct TCPHeader {
     uint16_t uptr = 0;          //!< urgent pointer
     //!@}
 
+    //! \name TCP options
+    //!@{
+    std::optional<uint16_t> mss{};              //!< Maximum segment size option, only sent on SYN segments
+    std::optional<uint8_t> window_scale{};      //!< Window scale option (shift count), only sent on SYN segments
+    std::optional<TCPTimestamps> timestamps{};  //!< Timestamps option
+    bool sack_permitted = false;                //!< SACK-permitted option, only sent on SYN segments
+    std::vector<SACKBlock> sack{};              //!< SACK option; blocks that do not fit in the options are dropped
+    //!@}
+
     //! Parse the TCP fields from the provided NetParser
     ParseResult parse(NetParser &p);
 
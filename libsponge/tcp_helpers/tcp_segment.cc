@@ -3,6 +3,8 @@
 #include "parser.hh"
 #include "util.hh"
 
+#include <algorithm>
+#include <string>
 #include <variant>
 
 using namespace std;
@@ -26,15 +28,97 @@ size_t TCPSegment::length_in_sequence_space() const {
     return payload().str().size() + (header().syn ? 1 : 0) + (header().fin ? 1 : 0);
 }
 
+//! \param[in] max_payload the most payload of any piece (e.g. the MSS)
+//! \returns the pieces in sequence order; just a copy of this segment if its payload already fits
+vector<TCPSegment> TCPSegment::split(const size_t max_payload) const {
+    const size_t size = _payload.size();
+    if (max_payload == 0 or size <= max_payload) {
+        return {*this};
+    }
+
+    vector<TCPSegment> pieces;
+    pieces.reserve((size + max_payload - 1) / max_payload);
+    for (size_t offset = 0; offset < size; offset += max_payload) {
+        const size_t piece_size = min(max_payload, size - offset);
+        const bool last = offset + piece_size == size;
+
+        TCPSegment &piece = pieces.emplace_back();
+        piece._header = _header;
+        piece._header.seqno = _header.seqno + static_cast<uint32_t>(offset + (offset > 0 and _header.syn));
+        piece._header.syn = _header.syn and offset == 0;
+        piece._header.fin = _header.fin and last;
+        piece._header.psh = _header.psh and last;
+        piece._payload = _payload;
+        piece._payload.remove_prefix(offset);
+        piece._payload.remove_suffix(size - offset - piece_size);
+    }
+    return pieces;
+}
+
+bool TCPSegment::continued_by(const TCPSegment &next) const {
+    const auto carries_plain_data = [](const TCPHeader &h, const Buffer &payload) {
+        return payload.size() > 0 and not(h.syn or h.fin or h.rst or h.urg);
+    };
+    if (not carries_plain_data(_header, _payload) or not carries_plain_data(next._header, next._payload) or
+        _header.psh or next._header.seqno != _header.seqno + static_cast<uint32_t>(_payload.size())) {
+        return false;
+    }
+
+    TCPHeader expected = next._header;
+    expected.seqno = _header.seqno;
+    expected.psh = _header.psh;
+    expected.cksum = _header.cksum;
+    return expected == _header;
+}
+
+//! \param[in] segments the segments in the order they arrived
+//! \param[in] max_payload the most payload of any run of more than one segment
+//! \returns the segments in the same order, split into runs of mergeable segments (many of just one)
+vector<vector<TCPSegment>> TCPSegment::coalesce(vector<TCPSegment> segments, const size_t max_payload) {
+    vector<vector<TCPSegment>> runs;
+    size_t run_payload = 0;
+    for (auto &seg : segments) {
+        if (runs.empty() or not runs.back().back().continued_by(seg) or
+            run_payload + seg._payload.size() > max_payload) {
+            runs.emplace_back();
+            run_payload = 0;
+        }
+        run_payload += seg._payload.size();
+        runs.back().push_back(move(seg));
+    }
+    return runs;
+}
+
+uint16_t TCPSegment::payload_sum() const {
+    const string_view payload = _payload.str();
+    const string_view summed = _summed_payload.str();
+    if (payload.data() != summed.data() or payload.size() != summed.size()) {
+        InternetChecksum check;
+        check.add(payload);
+        _payload_sum = ~check.value();
+        _summed_payload = _payload;
+    }
+    return _payload_sum;
+}
+
+//! \param[in] payload the new payload
+//! \param[in] payload_sum the ones' complement sum of `payload`, as returned by payload_sum()
+void TCPSegment::set_payload(const Buffer &payload, const uint16_t payload_sum) {
+    _payload = payload;
+    _summed_payload = payload;
+    _payload_sum = payload_sum;
+}
+
 //! \param[in] datagram_layer_checksum pseudo-checksum from the lower-layer protocol
+//! \details The header is a multiple of four bytes long, so the payload's sum can be computed
+//! separately and combined with the header's (see [RFC 1624](\ref rfc::rfc1624)).
 BufferList TCPSegment::serialize(const uint32_t datagram_layer_checksum) const {
     TCPHeader header_out = _header;
     header_out.cksum = 0;
 
     // calculate checksum -- taken over entire segment
-    InternetChecksum check(datagram_layer_checksum);
+    InternetChecksum check(datagram_layer_checksum + payload_sum());
     check.add(header_out.serialize());
-    check.add(_payload);
     header_out.cksum = check.value();
 
     BufferList ret;
@@ -5,6 +5,7 @@
 #include "tcp_header.hh"
 
 #include <cstdint>
+#include <vector>
 
 //! \brief [TCP](\ref rfc::rfc793) segment
 class TCPSegment {
@@ -12,6 +13,15 @@ class TCPSegment {
     TCPHeader _header{};
     Buffer _payload{};
 
+    //! \brief The payload whose ones' complement sum is cached in `_payload_sum`
+    //! \details Holding a reference keeps its (immutable) storage alive, so the cached sum
+    //! stays valid for as long as `_payload` still views exactly the same bytes.
+    mutable Buffer _summed_payload{};
+    mutable uint16_t _payload_sum{};  //!< Cached ones' complement sum of `_summed_payload`
+
+    //! \brief Could `next` be appended to this segment's payload without changing what either means?
+    bool continued_by(const TCPSegment &next) const;
+
   public:
     //! \brief Parse the segment from a string
     ParseResult parse(const Buffer buffer, const uint32_t datagram_layer_checksum = 0);
@@ -28,9 +38,29 @@ class TCPSegment {
     Buffer &payload() { return _payload; }
     //!@}
 
+    //! \brief Ones' complement sum of the payload, for use in the TCP checksum
+    //! \details The sum is cached, so serializing the same payload again (e.g. a retransmission,
+    //! or a copy whose header fields were rewritten) only re-sums the header.
+    uint16_t payload_sum() const;
+
+    //! \brief Set the payload together with its ones' complement sum, already known from an earlier segment
+    //! \details Lets a segment rebuilt from a stored payload (e.g. a retransmission) skip summing it again.
+    void set_payload(const Buffer &payload, const uint16_t payload_sum);
+
     //! \brief Segment's length in sequence space
     //! \note Equal to payload length plus one byte if SYN is set, plus one byte if FIN is set
     size_t length_in_sequence_space() const;
+
+    //! \brief Split into segments carrying at most `max_payload` bytes each, as segmentation offload would
+    //! \details The pieces share this segment's payload storage and copy its header and options. SYN stays
+    //! on the first piece, and FIN and PSH on the last.
+    std::vector<TCPSegment> split(const size_t max_payload) const;
+
+    //! \brief Group the runs of contiguous, in-order data segments that receive offload would merge
+    //! \details Segments join a run only if their headers (including options) match apart from the sequence
+    //! number, and if none but the last carries PSH. Segments with SYN, FIN, RST or URG are left alone.
+    //! Payloads are not copied into one; TCPConnection::segments_received() takes a run as a single segment.
+    static std::vector<std::vector<TCPSegment>> coalesce(std::vector<TCPSegment> segments, const size_t max_payload);
 };
 
 #endif  // SPONGE_LIBSPONGE_TCP_SEGMENT_HH
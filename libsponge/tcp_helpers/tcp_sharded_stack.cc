@@ -0,0 +1,118 @@
+#include "tcp_sharded_stack.hh"
+
+#include "eventloop.hh"
+
+#include <optional>
+#include <stdexcept>
+#include <utility>
+
+using namespace std;
+
+static constexpr size_t TCP_TICK_MS = 10;
+
+//! Most segments that may wait in one shard's inbox; more are dropped, like a full NIC receive ring
+static constexpr size_t INBOX_CAPACITY = 4096;
+
+//! Most segments read from the adapter before the shards they went to are woken
+static constexpr size_t MAX_DISPATCH_BATCH = 64;
+
+template <typename AdaptT>
+ShardedTCPStack<AdaptT>::ShardedTCPStack(AdaptT &&adapter, const size_t shard_count, const TCPConfig &cfg)
+    : _adapter(move(adapter)) {
+    if (shard_count == 0) {
+        throw runtime_error("ShardedTCPStack: needs at least one shard");
+    }
+
+    const auto writer = [this](const Address &peer, const FourTuple &tuple, TCPSegment &seg) {
+        _adapter.write(peer, tuple, seg);
+    };
+    for (size_t i = 0; i < shard_count; i++) {
+        _inboxes.push_back(make_shared<ShardAdapter::Inbox>(INBOX_CAPACITY));
+        _shards.push_back(make_unique<Shard>(ShardAdapter{_inboxes.back(), writer, _adapter.local_ip()}, cfg));
+    }
+}
+
+template <typename AdaptT>
+ShardedTCPStack<AdaptT>::~ShardedTCPStack() {
+    stop();
+}
+
+template <typename AdaptT>
+void ShardedTCPStack<AdaptT>::listen(const uint16_t port, const size_t backlog) {
+    if (not _threads.empty()) {
+        throw runtime_error("ShardedTCPStack: listen() after start()");
+    }
+    for (auto &shard : _shards) {
+        shard->listen(port, backlog);
+    }
+}
+
+template <typename AdaptT>
+void ShardedTCPStack<AdaptT>::start(const Worker &worker) {
+    if (not _threads.empty()) {
+        throw runtime_error("ShardedTCPStack: already started");
+    }
+    _threads.emplace_back([this] { _dispatch_main(); });
+    for (size_t i = 0; i < _shards.size(); i++) {
+        _threads.emplace_back([this, i, worker] { _shard_main(i, worker); });
+    }
+}
+
+template <typename AdaptT>
+void ShardedTCPStack<AdaptT>::stop() {
+    _stop = true;
+    for (auto &thread : _threads) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+}
+
+//! \details Each shard is woken once per batch, however many of the batch's segments went to it. The adapter
+//! is read with try_read() until it is drained, so it is not polled between segments; a batch that stops at
+//! MAX_DISPATCH_BATCH resumes on the next event, since the adapter is still readable.
+template <typename AdaptT>
+void ShardedTCPStack<AdaptT>::_dispatch_main() {
+    vector<bool> pushed(_shards.size(), false);
+
+    EventLoop eventloop{EventLoop::Backend::Epoll};
+    eventloop.add_rule(_adapter, Direction::In, [&] {
+        size_t reads = 0;
+        optional<DemuxedSegment> demuxed{};
+        while (reads < MAX_DISPATCH_BATCH and _adapter.try_read(demuxed)) {
+            reads++;
+            if (demuxed) {
+                const size_t index = shard_of(demuxed->tuple);
+                pushed[index] = _inboxes[index]->push(move(demuxed.value())) or pushed[index];
+            }
+        }
+
+        for (size_t i = 0; i < pushed.size(); i++) {
+            if (pushed[i]) {
+                _inboxes[i]->notify();
+                pushed[i] = false;
+            }
+        }
+    });
+
+    while (not _stop) {
+        if (eventloop.wait_next_event(TCP_TICK_MS) == EventLoop::Result::Exit) {
+            break;
+        }
+    }
+}
+
+template <typename AdaptT>
+void ShardedTCPStack<AdaptT>::_shard_main(const size_t index, const Worker worker) {
+    Shard &shard = *_shards[index];
+    while (not _stop) {
+        shard.wait_next_event(TCP_TICK_MS);
+        worker(shard, index);
+    }
+}
+
+//! Specialize ShardedTCPStack for TCPOverUDPMuxAdapter
+template class ShardedTCPStack<TCPOverUDPMuxAdapter>;
+
+//! Specialize ShardedTCPStack for TCPOverIPv4OverTunMuxAdapter
+template class ShardedTCPStack<TCPOverIPv4OverTunMuxAdapter>;
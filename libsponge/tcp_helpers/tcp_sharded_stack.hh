@@ -0,0 +1,100 @@
+#ifndef SPONGE_LIBSPONGE_TCP_SHARDED_STACK_HH
+#define SPONGE_LIBSPONGE_TCP_SHARDED_STACK_HH
+
+#include "fd_adapter.hh"
+#include "shard_adapter.hh"
+#include "tcp_config.hh"
+#include "tcp_stack.hh"
+#include "tuntap_adapter.hh"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+//! \brief TCPStacks on a fixed set of threads, each serving the connections whose FourTuple hashes to it
+//! \details Like receive-side scaling on a NIC, a dispatcher thread reads every segment from the one
+//! adapter and hands it to shard FourTupleHash(tuple) % shard_count(), through a lock-free queue
+//! (see ShardAdapter). Each shard is a TCPStack run by its own worker thread, which owns every
+//! connection of the shard, so that connections never move between threads and no locks are taken.
+//! Shards write their segments to the adapter directly, so AdaptT::write() must be safe to call from
+//! several threads at once (it is for the adapters here, which only send on their fd).
+//!
+//! The owner's code runs on the worker threads: after each TCPStack::wait_next_event(), a worker
+//! calls the Worker function given to start() with its shard, which may accept, read, write and
+//! release the shard's connections. Shards accept connections only: a connection opened by a shard
+//! would need a local port whose FourTuple hashes back to that shard.
+//! \tparam AdaptT a multiplexing adapter, e.g. TCPOverUDPMuxAdapter or TCPOverIPv4OverTunMuxAdapter
+template <typename AdaptT>
+class ShardedTCPStack {
+  public:
+    //! One shard of connections
+    using Shard = TCPStack<ShardAdapter>;
+
+    //! Called by each worker thread in its loop, with its shard and the shard's index
+    using Worker = std::function<void(Shard &shard, const size_t index)>;
+
+  private:
+    AdaptT _adapter;  //!< Adapter to the underlying datagram socket (e.g., UDP or IP)
+
+    std::vector<std::shared_ptr<ShardAdapter::Inbox>> _inboxes{};  //!< Each shard's queue of inbound segments
+    std::vector<std::unique_ptr<Shard>> _shards{};                 //!< The shards
+
+    std::atomic_bool _stop{false};        //!< Flag used by the owner to make every thread return
+    std::vector<std::thread> _threads{};  //!< The dispatcher thread, then one worker thread per shard
+
+    //! Main loop of the dispatcher thread
+    void _dispatch_main();
+
+    //! Main loop of the worker thread of one shard
+    void _shard_main(const size_t index, const Worker worker);
+
+  public:
+    //! \brief Construct from the adapter that all shards will share
+    //! \param[in] adapter is the adapter to read segments from and write them to
+    //! \param[in] shard_count is the number of shards (and worker threads), e.g. one per core
+    //! \param[in] cfg is the configuration of every connection
+    ShardedTCPStack(AdaptT &&adapter, const size_t shard_count, const TCPConfig &cfg = {});
+
+    //! Stops the threads, aborting any remaining connections
+    ~ShardedTCPStack();
+
+    //! \brief Accept connections to a local port in every shard (before start())
+    //! \param[in] port is the local TCP port
+    //! \param[in] backlog is the backlog of each shard (see TCPStack::listen)
+    void listen(const uint16_t port, const size_t backlog);
+
+    //! \brief Start the dispatcher thread and one worker thread per shard
+    //! \param[in] worker is called by each worker thread after each TCPStack::wait_next_event()
+    void start(const Worker &worker);
+
+    //! \brief Make every thread return, and wait for them
+    void stop();
+
+    //! Number of shards
+    size_t shard_count() const { return _shards.size(); }
+
+    //! Index of the shard that serves a connection
+    size_t shard_of(const FourTuple &tuple) const { return FourTupleHash{}(tuple) % _shards.size(); }
+
+    //! \name
+    //! A ShardedTCPStack cannot be copied or moved, since its threads refer to it
+
+    //!@{
+    ShardedTCPStack(const ShardedTCPStack &other) = delete;
+    ShardedTCPStack &operator=(const ShardedTCPStack &other) = delete;
+    ShardedTCPStack(ShardedTCPStack &&other) = delete;
+    ShardedTCPStack &operator=(ShardedTCPStack &&other) = delete;
+    //!@}
+};
+
+//! Typedef for ShardedTCPStack over UDP
+using UDPShardedTCPStack = ShardedTCPStack<TCPOverUDPMuxAdapter>;
+
+//! Typedef for ShardedTCPStack over IPv4 on a TUN device
+using TunShardedTCPStack = ShardedTCPStack<TCPOverIPv4OverTunMuxAdapter>;
+
+#endif  // SPONGE_LIBSPONGE_TCP_SHARDED_STACK_HH
@@ -4,36 +4,68 @@
 #include "tun.hh"
 #include "util.hh"
 
+#include <algorithm>
 #include <cstddef>
 #include <exception>
 #include <iostream>
+#include <limits>
 #include <stdexcept>
 #include <string>
+#include <sys/eventfd.h>
 #include <sys/socket.h>
 #include <sys/syscall.h>
 #include <sys/types.h>
 #include <unistd.h>
 #include <utility>
+#include <vector>
 
 using namespace std;
 
-static constexpr size_t TCP_TICK_MS = 10;
+//! Most datagrams read from the adapter for one receive event
+static constexpr size_t MAX_RECEIVE_BATCH = 64;
+
+//! Most payload in a run of segments taken as one, about what one IPv4 datagram can carry
+static constexpr size_t MAX_COALESCED_PAYLOAD = 65535 - 60 - 60;
+
+//! \param[in] ms is how long to wait after `base_time_us`, or nothing to wait indefinitely
+//! \param[in] base_time_us is the time (see timestamp_us) that `ms` counts from
+//! \returns a poll timeout, in milliseconds, that lasts until at least `ms` after `base_time_us`
+static int timeout_after(const optional<size_t> ms, const uint64_t base_time_us) {
+    if (not ms.has_value()) {
+        return -1;
+    }
+    const uint64_t deadline = base_time_us + min<uint64_t>(ms.value(), numeric_limits<int>::max()) * 1000;
+    const uint64_t now = timestamp_us();
+    if (deadline <= now) {
+        return 0;
+    }
+    // round up, so that the TCPConnection's clock has reached its deadline when the wait ends
+    return static_cast<int>(min<uint64_t>((deadline - now + 999) / 1000, numeric_limits<int>::max()));
+}
 
 //! \param[in] condition is a function returning true if loop should continue
+//! \details The loop does not wake up periodically: it sleeps until the next event or until the
+//! TCPConnection's next timer is due (see TCPConnection::time_until_next_timer), so an idle
+//! connection costs nothing and short timeouts fire on time. Time is measured in microseconds,
+//! and the TCPConnection is ticked in whole milliseconds with the remainder carried over, so
+//! waking up often neither loses nor gains time. Ticking by a long sleep at once is safe for
+//! pacing, since TCPSender caps the pacing credit however long the tick.
 template <typename AdaptT>
 void TCPSpongeSocket<AdaptT>::_tcp_loop(const function<bool()> &condition) {
-    auto base_time = timestamp_ms();
+    uint64_t base_time = timestamp_us();
     while (condition()) {
-        auto ret = _eventloop.wait_next_event(TCP_TICK_MS);
+        _follow_owner();
+
+        auto ret = _eventloop.wait_next_event(timeout_after(_tcp->time_until_next_timer(), base_time));
         if (ret == EventLoop::Result::Exit or _abort) {
             break;
         }
 
         if (_tcp.value().active()) {
-            const auto next_time = timestamp_ms();
-            _tcp.value().tick(next_time - base_time);
-            _datagram_adapter.tick(next_time - base_time);
-            base_time = next_time;
+            const uint64_t elapsed_ms = (timestamp_us() - base_time) / 1000;
+            _tcp.value().tick(elapsed_ms);
+            _datagram_adapter.tick(elapsed_ms);
+            base_time += elapsed_ms * 1000;
         }
     }
 }
@@ -45,10 +77,83 @@ TCPSpongeSocket<AdaptT>::TCPSpongeSocket(pair<FileDescriptor, FileDescriptor> da
                                          AdaptT &&datagram_interface)
     : LocalStreamSocket(move(data_socket_pair.first))
     , _thread_data(move(data_socket_pair.second))
-    , _datagram_adapter(move(datagram_interface)) {
+    , _datagram_adapter(move(datagram_interface))
+    , _wakeup(SystemCall("eventfd", ::eventfd(0, EFD_CLOEXEC))) {
     _thread_data.set_blocking(false);
 }
 
+template <typename AdaptT>
+void TCPSpongeSocket<AdaptT>::_wake() {
+    const uint64_t one = 1;
+    _wakeup.write(string(reinterpret_cast<const char *>(&one), sizeof(one)));
+}
+
+template <typename AdaptT>
+void TCPSpongeSocket<AdaptT>::cork() {
+    _cork.store(true);
+    _wake();
+}
+
+template <typename AdaptT>
+void TCPSpongeSocket<AdaptT>::uncork() {
+    _cork.store(false);
+    _wake();
+}
+
+template <typename AdaptT>
+void TCPSpongeSocket<AdaptT>::flush() {
+    _cork.store(false);
+    _flush.store(true);
+    _wake();
+}
+
+//! \details The owner changes `_cork` before it writes the data that the change is meant for, so rule 2 calls
+//! this before reading that data. A flush also reads what the owner wrote before it, which may still be
+//! waiting in the socket pair, so that the flush covers it.
+template <typename AdaptT>
+void TCPSpongeSocket<AdaptT>::_follow_owner() {
+    if (_cork.load() != _corked) {
+        _corked = not _corked;
+        if (_corked) {
+            _tcp->cork();
+        } else {
+            _tcp->uncork();
+        }
+    }
+
+    if (_flush.exchange(false) and _tcp->active()) {
+        _read_outbound();
+        _tcp->flush();
+    }
+}
+
+template <typename AdaptT>
+void TCPSpongeSocket<AdaptT>::_read_outbound() {
+    if (_outbound_shutdown or _tcp->remaining_outbound_capacity() == 0) {
+        return;
+    }
+
+    string data;
+    if (not _thread_data.try_read(data, _tcp->remaining_outbound_capacity())) {
+        return;
+    }
+    const auto len = data.size();
+    const auto amount_written = _tcp->write(move(data));
+    if (amount_written != len) {
+        throw runtime_error("TCPConnection::write() accepted less than advertised length");
+    }
+
+    if (_thread_data.eof()) {
+        _tcp->end_input_stream();
+        _outbound_shutdown = true;
+
+        // debugging output:
+        cerr << "DEBUG: Outbound stream to " << _datagram_adapter.config().destination.to_string() << " finished ("
+             << _tcp.value().bytes_in_flight() << " byte" << (_tcp.value().bytes_in_flight() == 1 ? "" : "s")
+             << " still in flight).\n";
+    }
+}
+
 template <typename AdaptT>
 void TCPSpongeSocket<AdaptT>::_initialize_TCP(const TCPConfig &config) {
     _tcp.emplace(config);
@@ -70,14 +175,31 @@ void TCPSpongeSocket<AdaptT>::_initialize_TCP(const TCPConfig &config) {
     //
     // 4) Outbound segment generated by TCP (needs to be
     //    given to underlying datagram socket)
+    //
+    // The loop also wakes up when the owner signals `_wakeup` (rule 5),
+    // and when the TCPConnection's next timer is due.
 
-    // rule 1: read from filtered packet stream and dump into TCPConnection
+    // rule 1: read from filtered packet stream and dump into TCPConnection. Every datagram
+    // that is already waiting is read (until a non-blocking read finds none), and runs of contiguous
+    // data segments are grouped, so the TCPConnection does the per-segment work (and sends an ACK)
+    // once per run, while the reassembler still takes each segment's payload without a copy.
     _eventloop.add_rule(_datagram_adapter,
                         Direction::In,
                         [&] {
-                            auto seg = _datagram_adapter.read();
-                            if (seg) {
-                                _tcp->segment_received(move(seg.value()));
+                            vector<TCPSegment> batch;
+                            optional<TCPSegment> seg;
+                            for (size_t reads = 0; reads < MAX_RECEIVE_BATCH and _datagram_adapter.try_read(seg);
+                                 reads++) {
+                                if (seg) {
+                                    batch.push_back(move(seg.value()));
+                                }
+                            }
+
+                            for (const auto &run : TCPSegment::coalesce(move(batch), MAX_COALESCED_PAYLOAD)) {
+                                if (not _tcp->active()) {
+                                    break;
+                                }
+                                _tcp->segments_received(run);
                             }
 
                             // debugging output:
@@ -90,27 +212,13 @@ void TCPSpongeSocket<AdaptT>::_initialize_TCP(const TCPConfig &config) {
                         },
                         [&] { return _tcp->active(); });
 
-    // rule 2: read from pipe into outbound buffer
+    // rule 2: read from pipe into outbound buffer, once a cork or flush that came before the data is applied
     _eventloop.add_rule(
         _thread_data,
         Direction::In,
         [&] {
-            const auto data = _thread_data.read(_tcp->remaining_outbound_capacity());
-            const auto len = data.size();
-            const auto amount_written = _tcp->write(move(data));
-            if (amount_written != len) {
-                throw runtime_error("TCPConnection::write() accepted less than advertised length");
-            }
-
-            if (_thread_data.eof()) {
-                _tcp->end_input_stream();
-                _outbound_shutdown = true;
-
-                // debugging output:
-                cerr << "DEBUG: Outbound stream to " << _datagram_adapter.config().destination.to_string()
-                     << " finished (" << _tcp.value().bytes_in_flight() << " byte"
-                     << (_tcp.value().bytes_in_flight() == 1 ? "" : "s") << " still in flight).\n";
-            }
+            _follow_owner();
+            _read_outbound();
         },
         [&] { return (_tcp->active()) and (not _outbound_shutdown) and (_tcp->remaining_outbound_capacity() > 0); },
         [&] {
@@ -128,8 +236,8 @@ void TCPSpongeSocket<AdaptT>::_initialize_TCP(const TCPConfig &config) {
             // the pipe, handling the possibility of a partial
             // write (i.e., only pop what was actually written).
             const size_t amount_to_write = min(size_t(65536), inbound.buffer_size());
-            const std::string buffer = inbound.peek_output(amount_to_write);
-            const auto bytes_written = _thread_data.write(move(buffer), false);
+            const BufferList buffer = inbound.peek_buffers(amount_to_write);
+            const auto bytes_written = _thread_data.write(buffer, false);
             inbound.pop_output(bytes_written);
 
             if (inbound.eof() or inbound.error()) {
@@ -147,18 +255,36 @@ void TCPSpongeSocket<AdaptT>::_initialize_TCP(const TCPConfig &config) {
         [&] {
             return (not _tcp->inbound_stream().buffer_empty()) or
                    ((_tcp->inbound_stream().eof() or _tcp->inbound_stream().error()) and not _inbound_shutdown);
-        });
+        },
+        [&] { _inbound_shutdown = true; });
 
-    // rule 4: read outbound segments from TCPConnection and send as datagrams
+    // rule 4: read outbound segments from TCPConnection and send as datagrams,
+    // splitting any that hold more than one MSS of payload (see TCPConfig::gso_segments)
     _eventloop.add_rule(_datagram_adapter,
                         Direction::Out,
                         [&] {
                             while (not _tcp->segments_out().empty()) {
-                                _datagram_adapter.write(_tcp->segments_out().front());
+                                TCPSegment &seg = _tcp->segments_out().front();
+                                if (seg.payload().size() <= _tcp->mss()) {
+                                    _datagram_adapter.write(seg);
+                                } else {
+                                    for (auto &piece : seg.split(_tcp->mss())) {
+                                        _datagram_adapter.write(piece);
+                                    }
+                                }
                                 _tcp->segments_out().pop();
                             }
                         },
                         [&] { return not _tcp->segments_out().empty(); });
+
+    // rule 5: wake up to notice a change to `_cork`, `_flush` or `_abort`. Once the TCPConnection is
+    // inactive, rule 3 stays interested until it shuts down the inbound stream or is canceled,
+    // so this rule never keeps the loop from exiting.
+    _eventloop.add_rule(
+        _wakeup,
+        Direction::In,
+        [&] { _wakeup.read(sizeof(uint64_t)); },
+        [&] { return _tcp->active() or not _inbound_shutdown; });
 }
 
 //! \brief Call [socketpair](\ref man2::socketpair) and return connected Unix-domain sockets of specified type
@@ -182,6 +308,7 @@ TCPSpongeSocket<AdaptT>::~TCPSpongeSocket() {
             cerr << "Warning: unclean shutdown of TCPSpongeSocket\n";
             // force the other side to exit
             _abort.store(true);
+            _wake();
             _tcp_thread.join();
         }
     } catch (const exception &e) {
@@ -286,6 +413,7 @@ CS144TCPSocket::CS144TCPSocket() : TCPOverIPv4SpongeSocket(TCPOverIPv4OverTunFdA
 void CS144TCPSocket::connect(const Address &address) {
     TCPConfig tcp_config;
     tcp_config.rt_timeout = 100;
+    tcp_config.fast_retransmit = true;
 
     FdAdapterConfig multiplexer_config;
     multiplexer_config.source = {"169.254.144.9", to_string(uint16_t(random_device()()))};
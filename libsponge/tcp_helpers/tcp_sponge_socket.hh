@@ -35,6 +35,18 @@ class TCPSpongeSocket : public LocalStreamSocket {
     //! eventloop that handles all the events (new inbound datagram, new outbound bytes, new inbound bytes)
     EventLoop _eventloop{};
 
+    //! An eventfd that the owner signals to wake the TCPConnection thread after changing `_cork`, `_flush` or `_abort`
+    FileDescriptor _wakeup;
+
+    //! Wake the TCPConnection thread, which otherwise sleeps until its next event or timer
+    void _wake();
+
+    //! Apply the owner's latest cork(), uncork() or flush() to the TCPConnection (TCPConnection thread only)
+    void _follow_owner();
+
+    //! Pass what the owner has written to the TCPConnection, as far as the outbound stream has room
+    void _read_outbound();
+
     //! Process events while specified condition is true
     void _tcp_loop(const std::function<bool()> &condition);
 
@@ -55,6 +67,12 @@ class TCPSpongeSocket : public LocalStreamSocket {
 
     bool _fully_acked{false};  //!< Has the outbound data been fully acknowledged by the peer?
 
+    std::atomic_bool _cork{false};  //!< Has the owner corked the outbound data?
+
+    bool _corked{false};  //!< Is the TCPConnection corked? (follows `_cork` from the TCPConnection thread)
+
+    std::atomic_bool _flush{false};  //!< Has the owner asked to send everything written so far?
+
   public:
     //! Construct from the interface that the TCPConnection thread will use to read and write datagrams
     explicit TCPSpongeSocket(AdaptT &&datagram_interface);
@@ -70,6 +88,15 @@ class TCPSpongeSocket : public LocalStreamSocket {
     //! Listen and accept using the specified configurations; blocks until accept succeeds or fails
     void listen_and_accept(const TCPConfig &c_tcp, const FdAdapterConfig &c_ad);
 
+    //! \brief Send only full segments until uncork(), so that many small writes share segments (like TCP_CORK)
+    void cork();
+
+    //! \brief Stop corking; the TCPConnection thread sends what the cork held back right away
+    void uncork();
+
+    //! \brief Uncork, and send everything written so far right away, even what Nagle's algorithm holds back
+    void flush();
+
     //! When a connected socket is destructed, it will send a RST
     ~TCPSpongeSocket();
 
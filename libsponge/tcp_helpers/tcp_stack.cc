@@ -0,0 +1,295 @@
+#include "tcp_stack.hh"
+
+#include "shard_adapter.hh"
+#include "util.hh"
+
+#include <stdexcept>
+#include <utility>
+
+using namespace std;
+
+//! Most segments read from the adapter for one receive event
+static constexpr size_t MAX_RECEIVE_BATCH = 64;
+
+//! Ephemeral ports used by connect() (RFC 6335)
+static constexpr uint16_t EPHEMERAL_PORT_FIRST = 49152;
+
+template <typename AdaptT>
+TCPStack<AdaptT>::TCPStack(AdaptT &&adapter, const TCPConfig &cfg)
+    : _adapter(move(adapter)), _cfg(cfg), _timers(timestamp_ms()), _next_ephemeral_port(EPHEMERAL_PORT_FIRST) {
+    _eventloop.add_rule(_adapter, Direction::In, [&] { _receive_batch(); });
+}
+
+template <typename AdaptT>
+void TCPStack<AdaptT>::_receive_batch() {
+    const uint64_t now = timestamp_ms();
+    size_t reads = 0;
+    optional<DemuxedSegment> demuxed{};
+    while (reads < MAX_RECEIVE_BATCH and _adapter.try_read(demuxed)) {
+        reads++;
+        if (demuxed) {
+            _segment_received(move(demuxed.value()), now);
+        }
+    }
+    _backlogged = reads == MAX_RECEIVE_BATCH;
+}
+
+template <typename AdaptT>
+typename TCPStack<AdaptT>::Connection &TCPStack<AdaptT>::_find(const FourTuple &id) {
+    auto it = _connections.find(id);
+    if (it == _connections.end()) {
+        throw runtime_error("TCPStack: no connection " + id.to_string());
+    }
+    return it->second;
+}
+
+//! \details A segment that names no connection creates one only if it is a SYN to a listening port
+//! whose backlog has room. A SYN that finds the backlog full is dropped, so its sender retransmits it
+//! later; anything else (other than a RST) is answered with a RST, as a closed port would.
+template <typename AdaptT>
+void TCPStack<AdaptT>::_segment_received(DemuxedSegment &&demuxed, const uint64_t now) {
+    const TCPHeader &header = demuxed.segment.header();
+
+    auto it = _connections.find(demuxed.tuple);
+    if (it == _connections.end()) {
+        if (header.rst) {
+            return;
+        }
+
+        auto listener = _listeners.find(demuxed.tuple.local_port);
+        if (listener == _listeners.end() or not header.syn or header.ack) {
+            _send_reset(demuxed);
+            return;
+        }
+        if (listener->second.pending >= listener->second.backlog) {
+            return;
+        }
+
+        it = _connections.try_emplace(demuxed.tuple, _cfg, demuxed.peer, now).first;
+        it->second.listener = demuxed.tuple.local_port;
+        listener->second.pending++;
+    }
+
+    const FourTuple &id = it->first;
+    Connection &connection = it->second;
+    _catch_up(connection, now);
+    connection.tcp.segment_received(demuxed.segment);
+
+    // has a passively opened connection completed the handshake?
+    if (connection.listener and not connection.queued and connection.tcp.active() and
+        connection.tcp.state() != TCPState{TCPState::State::SYN_RCVD}) {
+        connection.queued = true;
+        _listeners.at(connection.listener.value()).ready.push_back(id);
+    }
+
+    _settle(id, connection, now);
+}
+
+//! \details Follows the rules of RFC 793 for a segment that arrives at a CLOSED port.
+template <typename AdaptT>
+void TCPStack<AdaptT>::_send_reset(const DemuxedSegment &demuxed) {
+    const TCPHeader &header = demuxed.segment.header();
+
+    TCPSegment rst;
+    rst.header().rst = true;
+    if (header.ack) {
+        rst.header().seqno = header.ackno;
+    } else {
+        rst.header().ack = true;
+        rst.header().ackno = header.seqno + demuxed.segment.length_in_sequence_space();
+    }
+    _adapter.write(demuxed.peer, demuxed.tuple, rst);
+}
+
+//! \details Splits any segment that holds more than one MSS of payload (see TCPConfig::gso_segments).
+template <typename AdaptT>
+void TCPStack<AdaptT>::_send(const FourTuple &id, Connection &connection) {
+    auto &segments = connection.tcp.segments_out();
+    while (not segments.empty()) {
+        TCPSegment &seg = segments.front();
+        if (seg.payload().size() <= connection.tcp.mss()) {
+            _adapter.write(connection.peer, id, seg);
+        } else {
+            for (auto &piece : seg.split(connection.tcp.mss())) {
+                _adapter.write(connection.peer, id, piece);
+            }
+        }
+        segments.pop();
+    }
+}
+
+//! \details A connection that has finished is erased once its owner has released it, or right away
+//! if accept() never returned it (its listener forgets it too).
+template <typename AdaptT>
+bool TCPStack<AdaptT>::_reap(const FourTuple &id, Connection &connection) {
+    if (connection.tcp.active() or not(connection.released or connection.listener)) {
+        return false;
+    }
+
+    if (connection.listener) {
+        Listener &listener = _listeners.at(connection.listener.value());
+        listener.pending--;
+        if (connection.queued) {
+            auto &ready = listener.ready;
+            for (auto it = ready.begin(); it != ready.end(); ++it) {
+                if (*it == id) {
+                    ready.erase(it);
+                    break;
+                }
+            }
+        }
+    }
+
+    const FourTuple key = id;  // `id` may refer to the key being erased
+    _timers.cancel(key);
+    _connections.erase(key);
+    return true;
+}
+
+//! \details Ticks the connection by the time since it was last ticked, in one call, so its timers, RTT
+//! samples and timestamps see the same clock as if it had been ticked all along. Pacing credit is the
+//! exception: TCPSender caps it however long the tick, so a long idle gap releases only a small burst.
+template <typename AdaptT>
+void TCPStack<AdaptT>::_catch_up(Connection &connection, const uint64_t now) {
+    if (now > connection.last_tick) {
+        if (connection.tcp.active()) {
+            connection.tcp.tick(now - connection.last_tick);
+        }
+        connection.last_tick = now;
+    }
+}
+
+template <typename AdaptT>
+void TCPStack<AdaptT>::_settle(const FourTuple &id, Connection &connection, const uint64_t now) {
+    _send(id, connection);
+    if (_reap(id, connection)) {
+        return;
+    }
+
+    const auto timer = connection.tcp.time_until_next_timer();
+    if (timer.has_value()) {
+        _timers.schedule(id, now + timer.value());
+    } else {
+        _timers.cancel(id);
+    }
+}
+
+template <typename AdaptT>
+void TCPStack<AdaptT>::listen(const uint16_t port, const size_t backlog) {
+    if (backlog == 0) {
+        throw runtime_error("TCPStack: listen() needs a backlog of at least one connection");
+    }
+    if (not _listeners.try_emplace(port, Listener{backlog}).second) {
+        throw runtime_error("TCPStack: already listening on port " + to_string(port));
+    }
+}
+
+template <typename AdaptT>
+optional<FourTuple> TCPStack<AdaptT>::accept(const uint16_t port) {
+    auto listener = _listeners.find(port);
+    if (listener == _listeners.end()) {
+        throw runtime_error("TCPStack: not listening on port " + to_string(port));
+    }
+
+    auto &ready = listener->second.ready;
+    if (ready.empty()) {
+        return {};
+    }
+
+    const FourTuple id = ready.front();
+    ready.pop_front();
+    listener->second.pending--;
+    _find(id).listener.reset();
+    return id;
+}
+
+template <typename AdaptT>
+FourTuple TCPStack<AdaptT>::connect(const Address &peer, const uint16_t port) {
+    FourTuple id{_adapter.local_ip(), 0, peer.ipv4_numeric(), port};
+
+    // find a local port that neither a listener nor another connection to the same remote endpoint uses
+    constexpr size_t EPHEMERAL_PORT_COUNT = 65536 - EPHEMERAL_PORT_FIRST;
+    for (size_t attempts = 0; attempts < EPHEMERAL_PORT_COUNT; attempts++) {
+        id.local_port = _next_ephemeral_port;
+        _next_ephemeral_port = _next_ephemeral_port == 65535 ? EPHEMERAL_PORT_FIRST : _next_ephemeral_port + 1;
+        if (_listeners.count(id.local_port) == 0 and _connections.count(id) == 0) {
+            const uint64_t now = timestamp_ms();
+            Connection &connection = _connections.try_emplace(id, _cfg, peer, now).first->second;
+            connection.tcp.connect();
+            _settle(id, connection, now);
+            return id;
+        }
+    }
+
+    throw runtime_error("TCPStack: no free local port to connect to " + peer.to_string());
+}
+
+template <typename AdaptT>
+size_t TCPStack<AdaptT>::write(const FourTuple &id, string &&data) {
+    const uint64_t now = timestamp_ms();
+    Connection &connection = _find(id);
+    _catch_up(connection, now);
+    const size_t written = connection.tcp.write(move(data));
+    _settle(id, connection, now);
+    return written;
+}
+
+template <typename AdaptT>
+void TCPStack<AdaptT>::end_input_stream(const FourTuple &id) {
+    const uint64_t now = timestamp_ms();
+    Connection &connection = _find(id);
+    _catch_up(connection, now);
+    connection.tcp.end_input_stream();
+    _settle(id, connection, now);
+}
+
+template <typename AdaptT>
+void TCPStack<AdaptT>::release(const FourTuple &id) {
+    Connection &connection = _find(id);
+    connection.released = true;
+    _reap(id, connection);
+}
+
+//! \details Waits no longer than until the next timer. A batch of segments that stopped at
+//! MAX_RECEIVE_BATCH continues without waiting, since an adapter may not signal the segments it
+//! has already taken in again (see ShardAdapter).
+template <typename AdaptT>
+EventLoop::Result TCPStack<AdaptT>::wait_next_event(const int timeout_ms) {
+    auto ret = EventLoop::Result::Success;
+    if (_backlogged) {
+        _receive_batch();
+    } else {
+        int timeout = timeout_ms;
+        const auto expiry = _timers.next_expiry();
+        if (expiry.has_value()) {
+            const uint64_t now = timestamp_ms();
+            const uint64_t until_expiry = expiry.value() > now ? expiry.value() - now : 0;
+            if (timeout < 0 or until_expiry < static_cast<uint64_t>(timeout)) {
+                timeout = static_cast<int>(until_expiry);
+            }
+        }
+        ret = _eventloop.wait_next_event(timeout);
+    }
+
+    const uint64_t now = timestamp_ms();
+    _expired.clear();
+    _timers.advance(now, _expired);
+    for (const FourTuple &id : _expired) {
+        auto it = _connections.find(id);
+        if (it != _connections.end()) {
+            _catch_up(it->second, now);
+            _settle(it->first, it->second, now);
+        }
+    }
+
+    return ret;
+}
+
+//! Specialize TCPStack for TCPOverUDPMuxAdapter
+template class TCPStack<TCPOverUDPMuxAdapter>;
+
+//! Specialize TCPStack for TCPOverIPv4OverTunMuxAdapter
+template class TCPStack<TCPOverIPv4OverTunMuxAdapter>;
+
+//! Specialize TCPStack for ShardAdapter (the shards of a ShardedTCPStack)
+template class TCPStack<ShardAdapter>;
@@ -0,0 +1,157 @@
+#ifndef SPONGE_LIBSPONGE_TCP_STACK_HH
+#define SPONGE_LIBSPONGE_TCP_STACK_HH
+
+#include "byte_stream.hh"
+#include "eventloop.hh"
+#include "fd_adapter.hh"
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+#include "timing_wheel.hh"
+#include "tuntap_adapter.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+//! \brief Many TCPConnections over one multiplexing datagram adapter, driven by the owner's thread
+//! \details Unlike TCPSpongeSocket, a TCPStack has no thread of its own: the owner calls
+//! wait_next_event() in its loop, which reads segments from the adapter, hands each one to the
+//! connection its FourTuple names, and fires the connections' timers. Connections are
+//! addressed by their FourTuple, and are created by connect() or by a SYN to a listening port,
+//! after which accept() returns them without blocking.
+//!
+//! Connections are not ticked periodically. Each one's next timer (see TCPConnection::time_until_next_timer)
+//! is kept in a TimingWheel, and a connection's clock is advanced only when its timer fires or just
+//! before it is handed a segment or data, so an idle connection costs nothing.
+//! \tparam AdaptT a multiplexing adapter, e.g. TCPOverUDPMuxAdapter, TCPOverIPv4OverTunMuxAdapter or ShardAdapter
+template <typename AdaptT>
+class TCPStack {
+  private:
+    //! A connection and what the stack knows about its owner
+    struct Connection {
+        TCPConnection tcp;  //!< TCP state machine
+        Address peer;       //!< Where the adapter sends this connection's segments
+
+        //! Local port of the listener that created this connection, until accept() returns it
+        std::optional<uint16_t> listener{};
+
+        bool queued{false};    //!< Has the handshake completed, putting the connection in its listener's queue?
+        bool released{false};  //!< Has the owner released the connection?
+        uint64_t last_tick;    //!< When the connection's clock was last advanced
+
+        Connection(const TCPConfig &cfg, const Address &p, const uint64_t now) : tcp(cfg), peer(p), last_tick(now) {}
+    };
+
+    //! A listening port
+    struct Listener {
+        size_t backlog;                 //!< Most connections that may be pending (handshaking or unaccepted)
+        size_t pending{0};              //!< Connections created by this listener and not yet accepted
+        std::deque<FourTuple> ready{};  //!< Connections that completed the handshake, in order
+    };
+
+    AdaptT _adapter;  //!< Adapter to the underlying datagram socket (e.g., UDP or IP)
+    TCPConfig _cfg;   //!< Configuration of every connection
+
+    std::unordered_map<FourTuple, Connection, FourTupleHash> _connections{};  //!< Connections by FourTuple
+    std::unordered_map<uint16_t, Listener> _listeners{};                      //!< Listeners by local port
+
+    EventLoop _eventloop{EventLoop::Backend::Epoll};  //!< Waits for inbound datagrams
+
+    TimingWheel<FourTuple, FourTupleHash> _timers;  //!< Each connection's next timer, in milliseconds
+    std::vector<FourTuple> _expired{};              //!< Connections whose timers just fired
+
+    uint16_t _next_ephemeral_port;  //!< Where connect() starts looking for a free local port
+    bool _backlogged{false};        //!< Did the last batch stop at its limit, so that more may be waiting?
+
+    //! Read and process the segments that the adapter has ready, up to a limit, without polling it
+    void _receive_batch();
+
+    //! Find a connection, or throw if there is none
+    Connection &_find(const FourTuple &id);
+
+    //! Hand a segment read from the adapter to its connection, creating one for a SYN to a listener
+    void _segment_received(DemuxedSegment &&demuxed, const uint64_t now);
+
+    //! Reply to a segment that belongs to no connection with a RST
+    void _send_reset(const DemuxedSegment &demuxed);
+
+    //! Write the segments that a connection has queued to the adapter
+    void _send(const FourTuple &id, Connection &connection);
+
+    //! Erase a connection if it has finished and nobody will look at it again
+    //! \returns whether the connection was erased
+    bool _reap(const FourTuple &id, Connection &connection);
+
+    //! Advance a connection's clock to `now`
+    void _catch_up(Connection &connection, const uint64_t now);
+
+    //! Send what a connection has queued, then erase it if it has finished, or else set its next timer
+    void _settle(const FourTuple &id, Connection &connection, const uint64_t now);
+
+  public:
+    //! \brief Construct from the adapter that all connections will share
+    //! \param[in] adapter is the adapter to read segments from and write them to
+    //! \param[in] cfg is the configuration of every connection
+    explicit TCPStack(AdaptT &&adapter, const TCPConfig &cfg = {});
+
+    //! \brief Accept connections to a local port
+    //! \param[in] port is the local TCP port
+    //! \param[in] backlog is the most connections that may be handshaking or waiting for accept() at once;
+    //! further SYNs are dropped (and retransmitted by their senders) until accept() makes room
+    void listen(const uint16_t port, const size_t backlog);
+
+    //! \brief Take the oldest connection to `port` that has completed the handshake, without blocking
+    //! \returns the connection, or nothing if there is none yet
+    std::optional<FourTuple> accept(const uint16_t port);
+
+    //! \brief Open a connection from a free local port
+    //! \param[in] peer is where the adapter sends the connection's segments (e.g., the remote UDP socket)
+    //! \param[in] port is the remote TCP port
+    //! \returns the new connection, which is ESTABLISHED once the peer answers the SYN
+    FourTuple connect(const Address &peer, const uint16_t port);
+
+    //! \name Operations on one connection
+    //! \note A connection passed to these must have been returned by accept() or connect() and not released.
+    //!@{
+
+    //! \brief Write data to the outbound byte stream, and send what the window allows
+    //! \returns the number of bytes accepted into the stream
+    size_t write(const FourTuple &id, std::string &&data);
+
+    //! \brief The inbound byte stream, with the data received from the peer
+    ByteStream &inbound_stream(const FourTuple &id) { return _find(id).tcp.inbound_stream(); }
+
+    //! \brief Shut down the outbound byte stream, and send the FIN
+    void end_input_stream(const FourTuple &id);
+
+    //! \brief The TCP state machine, e.g. to examine its state()
+    const TCPConnection &connection(const FourTuple &id) { return _find(id).tcp; }
+
+    //! \brief Give up the connection: the stack erases it once it has finished
+    //! \details The connection keeps closing cleanly (e.g., it still retransmits its FIN, and waits in TIME_WAIT).
+    void release(const FourTuple &id);
+    //!@}
+
+    //! \brief Wait for segments or for the next timer, and process them
+    //! \param[in] timeout_ms is the longest to wait (or -1 to wait until a segment arrives or a timer fires)
+    //! \returns EventLoop::Result::Exit if the adapter has closed
+    EventLoop::Result wait_next_event(const int timeout_ms);
+
+    //! Number of connections in the table, including ones that are handshaking or closing
+    size_t connection_count() const { return _connections.size(); }
+
+    //! Access the underlying adapter
+    AdaptT &adapter() { return _adapter; }
+};
+
+//! Typedef for TCPStack over UDP
+using UDPTCPStack = TCPStack<TCPOverUDPMuxAdapter>;
+
+//! Typedef for TCPStack over IPv4 on a TUN device
+using TunTCPStack = TCPStack<TCPOverIPv4OverTunMuxAdapter>;
+
+#endif  // SPONGE_LIBSPONGE_TCP_STACK_HH
@@ -1,6 +1,46 @@
 #include "tuntap_adapter.hh"
 
+#include "ipv4_header.hh"
+#include "parser.hh"
+
 using namespace std;
 
+//! \param[in] datagram is the IPv4 datagram just read
+//! \returns a std::optional<DemuxedSegment> that is empty if the datagram was invalid or not for us
+optional<DemuxedSegment> TCPOverIPv4OverTunMuxAdapter::demux_tcp_in_tun(string &&datagram) const {
+    InternetDatagram ip_dgram;
+    if (ip_dgram.parse(Buffer::compacted(move(datagram))) != ParseResult::NoError) {
+        return {};
+    }
+
+    // is the IPv4 datagram a TCP segment for us?
+    if (ip_dgram.header().dst != _local_ip or ip_dgram.header().proto != IPv4Header::PROTO_TCP) {
+        return {};
+    }
+
+    TCPSegment seg;
+    if (ParseResult::NoError != seg.parse(ip_dgram.payload(), ip_dgram.header().pseudo_cksum())) {
+        return {};
+    }
+
+    const FourTuple tuple{_local_ip, seg.header().dport, ip_dgram.header().src, seg.header().sport};
+    return DemuxedSegment{tuple, Address::from_ipv4_numeric(tuple.remote_ip, tuple.remote_port), move(seg)};
+}
+
+//! \param[in] tuple is the connection that `seg` belongs to
+//! \param[in] seg is the TCP segment to convert and write
+void TCPOverIPv4OverTunMuxAdapter::write(const Address &, const FourTuple &tuple, TCPSegment &seg) {
+    seg.header().sport = tuple.local_port;
+    seg.header().dport = tuple.remote_port;
+
+    InternetDatagram ip_dgram;
+    ip_dgram.header().src = tuple.local_ip;
+    ip_dgram.header().dst = tuple.remote_ip;
+    ip_dgram.header().len = ip_dgram.header().hlen * 4 + seg.header().doff * 4 + seg.payload().size();
+    ip_dgram.payload() = seg.serialize(ip_dgram.header().pseudo_cksum());
+
+    _tun.write(ip_dgram.serialize());
+}
+
 //! Specialize LossyFdAdapter to TCPOverIPv4OverTunFdAdapter
 template class LossyFdAdapter<TCPOverIPv4OverTunFdAdapter>;
@@ -5,6 +5,7 @@
 #include "tun.hh"
 
 #include <optional>
+#include <string>
 #include <unordered_map>
 #include <utility>
 
@@ -13,19 +14,34 @@ class TCPOverIPv4OverTunFdAdapter : public TCPOverIPv4Adapter {
   private:
     TunFD _tun;
 
-  public:
-    //! Construct from a TunFD
-    explicit TCPOverIPv4OverTunFdAdapter(TunFD &&tun) : _tun(std::move(tun)) {}
-
-    //! Attempts to read and parse an IPv4 datagram containing a TCP segment related to the current connection
-    std::optional<TCPSegment> read() {
+    //! The TCP segment in a datagram read from the TUN device, if it is valid and related to the current connection
+    std::optional<TCPSegment> unwrap_tcp_in_tun(std::string &&datagram) {
         InternetDatagram ip_dgram;
-        if (ip_dgram.parse(_tun.read()) != ParseResult::NoError) {
+        if (ip_dgram.parse(Buffer::compacted(std::move(datagram))) != ParseResult::NoError) {
             return {};
         }
         return unwrap_tcp_in_ip(ip_dgram);
     }
 
+  public:
+    //! \brief Construct from a TunFD, which is made non-blocking so that try_read() can tell when it is drained
+    //! \note Writes to a TUN device never wait for room, so only reads are affected.
+    explicit TCPOverIPv4OverTunFdAdapter(TunFD &&tun) : _tun(std::move(tun)) { _tun.set_blocking(false); }
+
+    //! Attempts to read and parse an IPv4 datagram containing a TCP segment related to the current connection
+    std::optional<TCPSegment> read() { return unwrap_tcp_in_tun(_tun.read()); }
+
+    //! \brief Like read(), but only if a datagram is waiting
+    //! \returns `false` if no datagram was waiting; otherwise `segment` holds what read() would have returned
+    bool try_read(std::optional<TCPSegment> &segment) {
+        std::string datagram;
+        if (not _tun.try_read(datagram)) {
+            return false;
+        }
+        segment = unwrap_tcp_in_tun(std::move(datagram));
+        return true;
+    }
+
     //! Creates an IPv4 datagram from a TCP segment and writes it to the TUN device
     void write(TCPSegment &seg) { _tun.write(wrap_tcp_in_ip(seg).serialize()); }
 
@@ -39,4 +55,51 @@ class TCPOverIPv4OverTunFdAdapter : public TCPOverIPv4Adapter {
 //! Typedef for TCPOverIPv4OverTunFdAdapter
 using LossyTCPOverIPv4OverTunFdAdapter = LossyFdAdapter<TCPOverIPv4OverTunFdAdapter>;
 
+//! \brief A FD adapter for the IPv4 datagrams of many TCP connections on one TUN device
+//! \details Returns every TCP segment addressed to the local address, with its FourTuple
+//! (see TCPOverUDPMuxAdapter); the peer of a connection is its remote address and port.
+class TCPOverIPv4OverTunMuxAdapter {
+  private:
+    TunFD _tun;
+    uint32_t _local_ip;
+
+    //! The TCP segment in a datagram read from the TUN device, and its connection, if it is addressed to us
+    std::optional<DemuxedSegment> demux_tcp_in_tun(std::string &&datagram) const;
+
+  public:
+    //! \brief Construct from a TunFD and the local address of its connections
+    //! \details The TunFD is made non-blocking, as in TCPOverIPv4OverTunFdAdapter, so that try_read() can tell
+    //! when it is drained.
+    TCPOverIPv4OverTunMuxAdapter(TunFD &&tun, const Address &local)
+        : _tun(std::move(tun)), _local_ip(local.ipv4_numeric()) {
+        _tun.set_blocking(false);
+    }
+
+    //! Attempts to read and parse an IPv4 datagram containing a TCP segment addressed to the local address
+    std::optional<DemuxedSegment> read() { return demux_tcp_in_tun(_tun.read()); }
+
+    //! \brief Like read(), but only if a datagram is waiting
+    //! \returns `false` if no datagram was waiting; otherwise `demuxed` holds what read() would have returned
+    bool try_read(std::optional<DemuxedSegment> &demuxed) {
+        std::string datagram;
+        if (not _tun.try_read(datagram)) {
+            return false;
+        }
+        demuxed = demux_tcp_in_tun(std::move(datagram));
+        return true;
+    }
+
+    //! Creates an IPv4 datagram from a TCP segment of connection `tuple` and writes it to the TUN device
+    void write(const Address &peer, const FourTuple &tuple, TCPSegment &seg);
+
+    //! Address of the local endpoint of every connection
+    uint32_t local_ip() const { return _local_ip; }
+
+    //! Access the underlying TUN device
+    operator TunFD &() { return _tun; }
+
+    //! Access the underlying TUN device
+    operator const TunFD &() const { return _tun; }
+};
+
 #endif  // SPONGE_LIBSPONGE_TUNFD_ADAPTER_HH
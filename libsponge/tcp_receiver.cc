@@ -14,6 +14,9 @@ void DUMMY_CODE(Targs &&.../* unused */) {}
 
 using namespace std;
 
+//! Compare timestamps modulo 2^32, as sequence numbers are compared
+static bool timestamp_before(const uint32_t a, const uint32_t b) { return static_cast<int32_t>(a - b) < 0; }
+
 void TCPReceiver::segment_received(const TCPSegment &seg) {
     const TCPHeader head = seg.header();
     // Ignore segments without SYN if we haven't received a SYN yet
@@ -21,8 +24,8 @@ void TCPReceiver::segment_received(const TCPSegment &seg) {
         return;
     }
 
-    // Extract data from the payload
-    string data = seg.payload().copy();
+    // The payload is handed to the reassembler by reference, not copied
+    const Buffer &data = seg.payload();
 
     bool eof = false;
 
@@ -30,6 +33,15 @@ void TCPReceiver::segment_received(const TCPSegment &seg) {
     if (head.syn && !_synReceived) {
         _synReceived = true;
         _isn = head.seqno;
+        _sack_permitted = head.sack_permitted;
+        _mss = head.mss;
+        if (head.window_scale.has_value()) {
+            _window_scale = min(head.window_scale.value(), TCPHeader::MAX_WINDOW_SCALE);
+        }
+        if (head.timestamps.has_value()) {
+            _timestamps_permitted = true;
+            _ts_recent = head.timestamps->tsval;
+        }
 
         // Check if this is also a FIN packet (rare, but possible)
         if (head.fin) {
@@ -52,15 +64,57 @@ void TCPReceiver::segment_received(const TCPSegment &seg) {
     uint64_t abs_seqno = unwrap(head.seqno, _isn, checkpoint);
     uint64_t stream_idx = abs_seqno - _synReceived;
 
+    // Only a segment that starts at or before the ackno may update TS.Recent, so that
+    // the echo times the segment that advanced the window rather than a later one
+    if (head.timestamps.has_value() && abs_seqno > 0 && stream_idx <= checkpoint &&
+        !timestamp_before(head.timestamps->tsval, _ts_recent)) {
+        _ts_recent = head.timestamps->tsval;
+    }
+
     // push the data into stream reassembler
     _reassembler.push_substring(data, stream_idx, eof);
+
+    // Remember where the latest out-of-order data went, so SACK can report it first
+    if (data.size() > 0 && stream_idx > _reassembler.ack_index()) {
+        _latest_out_of_order_index = stream_idx;
+    }
+}
+
+bool TCPReceiver::is_old_duplicate(const TCPSegment &seg) const {
+    const TCPHeader &head = seg.header();
+    return _synReceived && !head.syn && !head.rst && head.timestamps.has_value() &&
+           timestamp_before(head.timestamps->tsval, _ts_recent);
 }
 
 optional<WrappingInt32> TCPReceiver::ackno() const {
     if (!_synReceived) {
         return nullopt;
     }
-    return wrap(_reassembler.ack_index() + 1 + (_reassembler.empty() && _finReceived), _isn);
+    return wrap(_reassembler.ack_index() + 1 + _reassembler.stream_out().input_ended(), _isn);
 }
 
 size_t TCPReceiver::window_size() const { return _capacity - _reassembler.stream_out().buffer_size(); }
+
+vector<SACKBlock> TCPReceiver::sack_blocks(const size_t max_blocks) const {
+    vector<SACKBlock> blocks;
+    if (!_synReceived) {
+        return blocks;
+    }
+
+    auto ranges = _reassembler.unassembled_ranges();
+    if (_latest_out_of_order_index.has_value()) {
+        const uint64_t latest = _latest_out_of_order_index.value();
+        const auto it = find_if(ranges.begin(), ranges.end(), [latest](const auto &range) {
+            return range.first <= latest && latest < range.second;
+        });
+        if (it != ranges.end()) {
+            rotate(ranges.begin(), it, it + 1);
+        }
+    }
+
+    // Stream index i is absolute seqno i + 1, after the SYN
+    for (size_t i = 0; i < min(max_blocks, ranges.size()); i++) {
+        blocks.push_back({wrap(ranges[i].first + 1, _isn), wrap(ranges[i].second + 1, _isn)});
+    }
+    return blocks;
+}
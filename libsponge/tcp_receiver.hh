@@ -7,6 +7,7 @@
 #include "wrapping_integers.hh"
 
 #include <optional>
+#include <vector>
 
 //! \brief The "receiver" part of a TCP implementation.
 
@@ -29,6 +30,24 @@ class TCPReceiver {
     //! Inital Squence Number
     WrappingInt32 _isn;
 
+    //! Flag to indicate whether the peer's SYN offered SACK
+    bool _sack_permitted{false};
+
+    //! Maximum segment size announced in the peer's SYN, if any
+    std::optional<uint16_t> _mss{};
+
+    //! Window scale shift count offered in the peer's SYN, if any
+    std::optional<uint8_t> _window_scale{};
+
+    //! Flag to indicate whether the peer's SYN carried timestamps
+    bool _timestamps_permitted{false};
+
+    //! TSval of the latest segment that reached the left edge of the window (TS.Recent in RFC 7323)
+    uint32_t _ts_recent{0};
+
+    //! Stream index of the most recent segment that arrived out of order
+    std::optional<uint64_t> _latest_out_of_order_index{};
+
   public:
     //! \brief Construct a TCP receiver
     //!
@@ -58,6 +77,35 @@ class TCPReceiver {
     //! accepted by the receiver) and (b) the sequence number of the
     //! beginning of the window (the ackno).
     size_t window_size() const;
+
+    //! \brief Whether the peer offered SACK (\ref rfc::rfc2018 "RFC 2018") in its SYN
+    bool sack_permitted() const { return _sack_permitted; }
+
+    //! \brief The maximum segment size the peer announced in its SYN, if any
+    std::optional<uint16_t> mss() const { return _mss; }
+
+    //! \brief The window scale shift count (\ref rfc::rfc7323 "RFC 7323") the peer offered in its SYN, if any
+    //!
+    //! This is the shift the peer applies to the windows it advertises, capped at TCPHeader::MAX_WINDOW_SCALE.
+    std::optional<uint8_t> window_scale() const { return _window_scale; }
+
+    //! \brief Whether the peer's SYN carried timestamps (\ref rfc::rfc7323 "RFC 7323")
+    bool timestamps_permitted() const { return _timestamps_permitted; }
+
+    //! \brief The TSecr to echo: the TSval of the latest segment that reached the left edge of the window
+    uint32_t ts_recent() const { return _ts_recent; }
+
+    //! \brief PAWS (\ref rfc::rfc7323 "RFC 7323"): is the segment's timestamp older than ts_recent()?
+    //!
+    //! Such a segment is an old duplicate, possibly from a previous wrap of the sequence space.
+    bool is_old_duplicate(const TCPSegment &seg) const;
+
+    //! \brief SACK blocks describing the data held beyond the ackno
+    //! \param max_blocks the most blocks to report
+    //!
+    //! The block holding the most recently received out-of-order segment comes first,
+    //! as RFC 2018 requires, followed by the others in sequence order.
+    std::vector<SACKBlock> sack_blocks(const size_t max_blocks = TCPHeader::MAX_SACK_BLOCKS) const;
     //!@}
 
     //! \brief number of bytes stored but not yet reassembled
@@ -5,6 +5,7 @@
 #include <random>
 // #include <iostream>
 #include <algorithm>
+#include <limits>
 
 // Dummy implementation of a TCP sender
 
@@ -31,11 +32,44 @@ using namespace std;
 //! \param[in] capacity the capacity of the outgoing byte stream
 //! \param[in] retx_timeout the initial amount of time to wait before retransmitting the oldest outstanding segment
 //! \param[in] fixed_isn the Initial Sequence Number to use, if set (otherwise uses a random ISN)
-TCPSender::TCPSender(const size_t capacity, const uint16_t retx_timeout, const std::optional<WrappingInt32> fixed_isn)
+//! \param[in] congestion_control the congestion control algorithm that limits how much may be in flight
+TCPSender::TCPSender(const size_t capacity,
+                     const uint16_t retx_timeout,
+                     const std::optional<WrappingInt32> fixed_isn,
+                     const TCPConfig::CongestionControl congestion_control)
     : _isn(fixed_isn.value_or(WrappingInt32{random_device()()}))
     , _initial_retransmission_timeout(retx_timeout)
     , _current_rto(retx_timeout)
-    , _stream(capacity) {}
+    , _stream(capacity)
+    , _congestion_algorithm(congestion_control)
+    , _congestion_control(CongestionController::make(congestion_control)) {}
+
+//! \param[in] cfg the connection's configuration, including how the retransmission timeout is chosen
+TCPSender::TCPSender(const TCPConfig &cfg)
+    : TCPSender(cfg.send_capacity, cfg.rt_timeout, cfg.fixed_isn, cfg.congestion_control) {
+    _rtt = RTTEstimator{cfg.rto_min, cfg.rto_max};
+    _adaptive_rto = cfg.adaptive_rto;
+    _fast_retransmit = cfg.fast_retransmit || _congestion_control;
+    _gso_segments = max(cfg.gso_segments, 1u);
+    _nagle = cfg.nagle;
+    _pacing = cfg.pacing;
+    _configured_pacing_rate = cfg.pacing_rate;
+    if (cfg.mss.has_value() && cfg.mss.value() < _mss) {
+        set_mss(cfg.mss.value());
+    }
+}
+
+//! \param[in] mss the largest payload to send in one segment on the wire
+//! \details Meant for the handshake: the congestion controller restarts with an initial window in the new MSS.
+void TCPSender::set_mss(const size_t mss) {
+    if (max<size_t>(mss, 1) == _mss) {
+        return;
+    }
+    _mss = max<size_t>(mss, 1);
+    if (_congestion_control) {
+        _congestion_control = CongestionController::make(_congestion_algorithm, _mss);
+    }
+}
 
 void TCPSender::fill_window() {
     // Send SYN if not sent yet
@@ -53,20 +87,30 @@ void TCPSender::fill_window() {
     }
 
     // Calculate available window size
-    uint16_t window_size = _window_size ? _window_size : 1;  // Treat 0 as 1 for zero window probing
+    uint64_t window_size = _window_size ? _window_size : 1;  // Treat 0 as 1 for zero window probing
     uint64_t abs_ackno = _next_seqno - _bytes_in_flight;
     uint64_t window_right_edge = abs_ackno + window_size;
+    if (_congestion_control) {
+        window_right_edge = abs_ackno + min<uint64_t>(window_size, _congestion_control->cwnd() + _recovery_inflation);
+    }
 
-    // Send data segments
+    // Send data segments, while the pacing credit (if any) is not in debt
+    const bool paced = pacing_rate() > 0;
     while (_next_seqno < window_right_edge &&
            (!_stream.buffer_empty() || (_stream.eof() && _state != State::FIN_SENT))) {
+        if (paced && _pacing_credit < 0) {
+            break;
+        }
         TCPSegment seg;
         size_t payload_size = min({_stream.buffer_size(),
                                    static_cast<size_t>(window_right_edge - _next_seqno),
-                                   static_cast<size_t>(TCPConfig::MAX_PAYLOAD_SIZE)});
+                                   _mss * _gso_segments});
+        if (hold_back(payload_size)) {
+            break;
+        }
 
         // Read data from the stream
-        seg.payload() = Buffer{_stream.read(payload_size)};
+        seg.payload() = _stream.read_buffer(payload_size);
 
         // Set FIN flag if this is the last segment and there's room in the window
         if (_stream.eof() && _next_seqno + seg.length_in_sequence_space() < window_right_edge) {
@@ -79,6 +123,9 @@ void TCPSender::fill_window() {
         }
 
         send_segment(seg);
+        if (paced) {
+            _pacing_credit -= seg.payload().size();
+        }
 
         if (seg.header().fin) {
             break;  // Stop after sending FIN
@@ -86,33 +133,110 @@ void TCPSender::fill_window() {
     }
 }
 
+void TCPSender::flush() {
+    _flushing = true;
+    fill_window();
+    _flushing = false;
+}
+
+//! \param[in] payload_size the payload of the next segment
+//! \details Nagle's algorithm (\ref rfc::rfc896 "RFC 896") holds back a segment smaller than the MSS while
+//! data is unacknowledged, and a cork holds back data until there is a full MSS of it. Neither holds back
+//! the last data before the FIN.
+bool TCPSender::hold_back(const size_t payload_size) const {
+    if (_flushing || payload_size >= _mss || (_stream.input_ended() && payload_size == _stream.buffer_size())) {
+        return false;
+    }
+    return (_corked && _stream.buffer_size() < _mss) || (_nagle && _bytes_in_flight > 0);
+}
+
 //! \param ackno The remote receiver's ackno (acknowledgment number)
-//! \param window_size The remote receiver's advertised window size
-void TCPSender::ack_received(const WrappingInt32 ackno, const uint16_t window_size) {
+//! \param window_size The remote receiver's advertised window size, in bytes
+//! \param pure_ack Whether the acknowledgment arrived on a segment that occupies no sequence space
+//! \param sack The SACK blocks that came with the acknowledgment
+//! \param tsecr The timestamp echoed with the acknowledgment
+void TCPSender::ack_received(const WrappingInt32 ackno,
+                             const uint64_t window_size,
+                             const bool pure_ack,
+                             const vector<SACKBlock> &sack,
+                             const optional<uint32_t> tsecr) {
     uint64_t abs_ackno = unwrap(ackno, _isn, _next_seqno);
     if (!is_ack_valid(abs_ackno)) {
         return;
     }
 
+    // Only newly SACKed segments can reveal a new loss, so the scoreboard is scanned only after them
+    const bool newly_sacked = !sack.empty() && sack_received(abs_ackno, sack);
+
+    // Duplicate ACKs are counted toward fast retransmit; without it the sender relies on the timer
+    if (_fast_retransmit && pure_ack && is_duplicate_ack(abs_ackno, window_size)) {
+        duplicate_ack_received(abs_ackno);
+        if (newly_sacked) {
+            retransmit_sack_holes(abs_ackno);
+        }
+        fill_window();
+        return;
+    }
+
     _window_size = window_size;
 
     // Process acknowledged segments
+    const uint64_t bytes_in_flight_before = _bytes_in_flight;
     bool segments_acked = false;
-    while (!_segments_outstanding.empty()) {
-        const auto &seg = _segments_outstanding.front();
-        uint64_t seg_seqno = unwrap(seg.header().seqno, _isn, _next_seqno);
-        if (seg_seqno + seg.length_in_sequence_space() <= abs_ackno) {
-            _bytes_in_flight -= seg.length_in_sequence_space();
-            _segments_outstanding.pop();
+    optional<uint64_t> first_send_time{};
+    bool retransmission_acked = false;
+    while (!_outstanding.empty()) {
+        const auto &head = _outstanding.front();
+        if (head.end() <= abs_ackno) {
+            if (!first_send_time.has_value()) {
+                first_send_time = head.send_time;
+            }
+            retransmission_acked |= head.retransmitted;
+            _sacked_segments -= head.sacked;
+            _bytes_in_flight -= head.length();
+            _outstanding.pop_front();
             segments_acked = true;
         } else {
+            if (head.abs_seqno < abs_ackno) {
+                trim_outstanding_head(abs_ackno);
+                segments_acked = true;
+            }
             break;
         }
     }
 
     if (segments_acked) {
-        // Reset retransmission parameters
-        _current_rto = _initial_retransmission_timeout;
+        _duplicate_acks = 0;
+        if (_in_fast_recovery) {
+            recovery_ack_received(abs_ackno, bytes_in_flight_before - _bytes_in_flight);
+        } else if (_congestion_control && _state != State::SYN_SENT) {
+            // The handshake does not grow the congestion window
+            _congestion_control->on_ack(bytes_in_flight_before - _bytes_in_flight, _now);
+        }
+
+        // A timestamp echo says exactly which transmission was acknowledged, even a retransmission.
+        // Without one, Karn's algorithm applies: an ACK that covers a retransmission is ambiguous, so it
+        // gives no sample. Measuring from the oldest segment it covers errs on the side of a longer RTT.
+        optional<uint64_t> rtt{};
+        if (tsecr.has_value()) {
+            const uint32_t echo_age = timestamp() - tsecr.value();
+            if (echo_age <= numeric_limits<int32_t>::max()) {
+                rtt = echo_age;
+            }
+        } else if (first_send_time.has_value() && !retransmission_acked) {
+            rtt = _now - first_send_time.value();
+        }
+        const bool rtt_sampled = rtt.has_value();
+        if (rtt_sampled) {
+            _rtt.sample(rtt.value());
+        }
+
+        // Reset retransmission parameters. An adaptive timeout stays backed off until a new sample arrives.
+        if (!_adaptive_rto) {
+            _current_rto = _initial_retransmission_timeout;
+        } else if (rtt_sampled) {
+            _current_rto = _rtt.rto();
+        }
         _consecutive_retransmissions = 0;
         reset_timer();
     }
@@ -123,30 +247,101 @@ void TCPSender::ack_received(const WrappingInt32 ackno, const uint16_t window_si
     }
 
     // Stop timer if all segments are acknowledged
-    if (_segments_outstanding.empty()) {
+    if (_outstanding.empty()) {
         stop_timer();
     }
 
+    if (newly_sacked) {
+        retransmit_sack_holes(abs_ackno);
+    }
+
     // Always try to fill the window after receiving an ACK
     fill_window();
 }
 
 //! \param[in] ms_since_last_tick the number of milliseconds since the last call to this method
 void TCPSender::tick(const size_t ms_since_last_tick) {
-    if (!_timer_running)
-        return;
-    _time_elapsed += ms_since_last_tick;
-    if (_time_elapsed >= _current_rto) {
-        _segments_out.push(_segments_outstanding.front());
+    _now += ms_since_last_tick;
+    if (_timer_running) {
+        _time_elapsed += ms_since_last_tick;
+    }
+    if (_timer_running && _time_elapsed >= _current_rto) {
+        retransmit_head();
+
+        // A timeout ends fast recovery, and duplicate ACKs for data sent before it must not start another
+        _in_fast_recovery = false;
+        _recovery_inflation = 0;
+        _recovery_point = _next_seqno;
+        _duplicate_acks = 0;
 
         // Update retransmission parameter
-        if (_window_size > 0 || _segments_outstanding.front().header().syn) {
+        if (_window_size > 0 || _outstanding.front().syn) {
+            // Only the first expiry for a segment is a new congestion signal
+            if (_congestion_control && _consecutive_retransmissions == 0) {
+                _congestion_control->on_rto(_bytes_in_flight, _now);
+            }
             _consecutive_retransmissions++;
             _current_rto <<= 1;  // Double the RTO
+            if (_adaptive_rto) {
+                _current_rto = min(_current_rto, _rtt.rto_max());
+            }
         }
 
         reset_timer();
     }
+
+    // Refill the pacing credit, and send what it allows. The credit never exceeds PACING_QUANTUM segments or
+    // PACING_BURST_MS of the rate, however long the tick, so a long idle gap does not release a burst.
+    const uint64_t rate = pacing_rate();
+    if (rate > 0) {
+        const int64_t refill = rate * ms_since_last_tick / 1000;
+        const int64_t depth = max<int64_t>(rate * PACING_BURST_MS / 1000, PACING_QUANTUM * _mss);
+        _pacing_credit = min(_pacing_credit + refill, depth);
+        if (_state == State::SYN_ACKED) {
+            fill_window();
+        }
+    }
+}
+
+optional<size_t> TCPSender::time_until_next_timer() const {
+    optional<size_t> next{};
+    if (_timer_running) {
+        next = _current_rto > _time_elapsed ? _current_rto - _time_elapsed : 0;
+    }
+
+    // a sender in pacing debt waits until tick() has refilled the credit
+    const uint64_t rate = pacing_rate();
+    if (rate > 0 && _pacing_credit < 0) {
+        const size_t refill = (static_cast<uint64_t>(-_pacing_credit) * 1000 + rate - 1) / rate;
+        next = next.has_value() ? min(next.value(), refill) : refill;
+    }
+    return next;
+}
+
+//! \details A configured rate is used as is. Otherwise, once there is an RTT sample, the rate is the window
+//! (cwnd, if smaller than the receiver's) per SRTT, scaled by PACING_GAIN_SLOW_START in slow start or by
+//! PACING_GAIN otherwise, so that pacing does not itself limit the window's growth.
+uint64_t TCPSender::pacing_rate() const {
+    if (!_pacing) {
+        return 0;
+    }
+    if (_configured_pacing_rate.has_value()) {
+        return _configured_pacing_rate.value();
+    }
+    if (!_rtt.has_sample()) {
+        return 0;
+    }
+
+    uint64_t window = _window_size;
+    double gain = PACING_GAIN;
+    if (_congestion_control) {
+        window = min<uint64_t>(window, _congestion_control->cwnd());
+        if (_congestion_control->cwnd() < _congestion_control->ssthresh()) {
+            gain = PACING_GAIN_SLOW_START;
+        }
+    }
+    // The clock only resolves milliseconds, so an SRTT below one is taken as one
+    return static_cast<uint64_t>(gain * window * 1000 / max(_rtt.srtt(), 1.0));
 }
 
 void TCPSender::send_empty_segment() {
@@ -156,22 +351,199 @@ void TCPSender::send_empty_segment() {
 }
 
 bool TCPSender::is_ack_valid(uint64_t abs_ackno) const {
-    if (_segments_outstanding.empty()) {
+    if (_outstanding.empty()) {
         return abs_ackno <= _next_seqno;
     }
-    uint64_t oldest_unacked = unwrap(_segments_outstanding.front().header().seqno, _isn, _next_seqno);
-    return abs_ackno <= _next_seqno && abs_ackno >= oldest_unacked;
+    return abs_ackno <= _next_seqno && abs_ackno >= _outstanding.front().abs_seqno;
 }
 
+//! \details An ACK is a duplicate if it acknowledges nothing new while data is outstanding and
+//! leaves the window unchanged (RFC 5681, section 2). Replies to zero window probes are not.
+bool TCPSender::is_duplicate_ack(const uint64_t abs_ackno, const uint64_t window_size) const {
+    if (_state == State::SYN_SENT || _outstanding.empty() || window_size == 0 || window_size != _window_size) {
+        return false;
+    }
+    return abs_ackno == _outstanding.front().abs_seqno;
+}
+
+//! \details The third duplicate ACK retransmits the oldest outstanding segment and enters fast
+//! recovery, unless it only acknowledges data sent before the last loss was detected. Only
+//! congestion control shrinks and inflates the window; without it, recovery just repairs losses.
+void TCPSender::duplicate_ack_received(const uint64_t abs_ackno) {
+    _duplicate_acks++;
+    if (_in_fast_recovery) {
+        // Each further duplicate ACK means another segment has left the network
+        _recovery_inflation += _mss;
+        return;
+    }
+
+    if (_duplicate_acks != DUPACK_THRESHOLD || abs_ackno < _recovery_point) {
+        return;
+    }
+
+    _in_fast_recovery = true;
+    _recovery_point = _next_seqno;
+    if (_congestion_control) {
+        _congestion_control->on_loss(_bytes_in_flight, _now);
+        _recovery_inflation = DUPACK_THRESHOLD * _mss;
+    }
+    retransmit_head();
+}
+
+//! \param[in] abs_ackno the acknowledgment that carried the SACK blocks
+//! \param[in] sack blocks of data that the receiver holds beyond `abs_ackno`
+//! \returns whether any segment was newly marked
+//! \details Marks every outstanding segment that lies entirely inside a block. Blocks that
+//! fall outside the outstanding data (including D-SACK reports) are ignored.
+bool TCPSender::sack_received(const uint64_t abs_ackno, const vector<SACKBlock> &sack) {
+    const size_t sacked_before = _sacked_segments;
+    for (const auto &block : sack) {
+        const uint64_t left = unwrap(block.left, _isn, _next_seqno);
+        const uint64_t right = unwrap(block.right, _isn, _next_seqno);
+        if (left <= abs_ackno || right <= left || right > _next_seqno) {
+            continue;
+        }
+
+        auto it = lower_bound(_outstanding.begin(), _outstanding.end(), left, [](const auto &seg, uint64_t seqno) {
+            return seg.abs_seqno < seqno;
+        });
+        for (; it != _outstanding.end() && it->end() <= right; ++it) {
+            _sacked_segments += !it->sacked;
+            it->sacked = true;
+        }
+    }
+    return _sacked_segments != sacked_before;
+}
+
+//! \param[in] abs_ackno the latest acknowledgment
+//! \details A segment that has not been SACKed is deemed lost once DUPACK_THRESHOLD segments
+//! above it have been (RFC 6675, IsLost). Each lost segment is retransmitted once, so every
+//! hole the receiver reports is repaired without waiting for the timer or a partial ACK, and
+//! data it already holds is never resent. The first loss found this way starts fast recovery.
+void TCPSender::retransmit_sack_holes(const uint64_t abs_ackno) {
+    if (_sacked_segments < DUPACK_THRESHOLD) {
+        return;
+    }
+
+    size_t sacked_above = 0;
+    auto lost_end = _outstanding.rend();
+    for (auto it = _outstanding.rbegin(); it != _outstanding.rend(); ++it) {
+        if (it->sacked) {
+            sacked_above++;
+        } else if (sacked_above >= DUPACK_THRESHOLD) {
+            lost_end = it;
+            break;
+        }
+    }
+    if (lost_end == _outstanding.rend()) {
+        return;
+    }
+
+    if (_congestion_control && !_in_fast_recovery && abs_ackno >= _recovery_point) {
+        _in_fast_recovery = true;
+        _recovery_point = _next_seqno;
+        _congestion_control->on_loss(_bytes_in_flight, _now);
+        _recovery_inflation = DUPACK_THRESHOLD * _mss;
+    }
+
+    // Retransmit in sequence order, up to and including the highest lost segment
+    for (auto it = _outstanding.begin(); it != lost_end.base(); ++it) {
+        if (!it->sacked && !it->retransmitted) {
+            retransmit(*it);
+        }
+    }
+}
+
+//! \param[in] abs_ackno an acknowledgment of new data received during fast recovery
+//! \param[in] acked_bytes number of sequence numbers it newly acknowledged
+//! \details An ACK covering everything sent before the loss was detected ends recovery. A partial
+//! ACK means the next segment was lost as well, so it is retransmitted immediately.
+void TCPSender::recovery_ack_received(const uint64_t abs_ackno, const size_t acked_bytes) {
+    if (abs_ackno >= _recovery_point) {
+        _in_fast_recovery = false;
+        _recovery_inflation = 0;
+        return;
+    }
+
+    // Deflate by the newly acknowledged data, then add back the segment that the retransmission replaces
+    _recovery_inflation -= min(_recovery_inflation, acked_bytes);
+    if (acked_bytes >= _mss) {
+        _recovery_inflation += _mss;
+    }
+
+    // SACK may already have repaired this hole
+    if (!_outstanding.front().retransmitted) {
+        retransmit_head();
+    }
+}
+
+//! \param[in] outstanding the segment to send again
+//! \details Rebuilds the segment's header from its seqno and flags. The payload's sum is kept from the first
+//! time the segment was summed, so only the header is summed again.
+void TCPSender::retransmit(OutstandingSegment &outstanding) {
+    TCPSegment seg;
+    seg.header().seqno = wrap(outstanding.abs_seqno, _isn);
+    seg.header().syn = outstanding.syn;
+    seg.header().fin = outstanding.fin;
+    if (outstanding.payload_sum.has_value()) {
+        seg.set_payload(outstanding.payload, outstanding.payload_sum.value());
+    } else {
+        seg.payload() = outstanding.payload;
+        outstanding.payload_sum = seg.payload_sum();
+    }
+    outstanding.send_time = _now;
+    outstanding.retransmitted = true;
+    _segments_out.push(move(seg));
+}
+
+void TCPSender::retransmit_head() { retransmit(_outstanding.front()); }
+
+//! \details A segment of up to one MSS is summed once, and the sum is kept with the outstanding segment for
+//! any retransmission. A segment of several MSS (GSO) is split into wire segments that are summed by the
+//! adapter, so it is never summed whole; it is kept as MSS-sized outstanding segments instead, so that each
+//! is retransmitted without being split again and keeps the sum from its first retransmission.
 void TCPSender::send_segment(TCPSegment &seg) {
     seg.header().seqno = wrap(_next_seqno, _isn);
+    const size_t size = seg.payload().size();
+    if (size <= _mss) {
+        const uint16_t payload_sum = seg.payload_sum();
+        _outstanding.push_back({_next_seqno, seg.payload(), _now, seg.header().syn, seg.header().fin, payload_sum});
+    } else {
+        uint64_t abs_seqno = _next_seqno;
+        for (size_t offset = 0; offset < size; offset += _mss) {
+            const size_t piece_size = min(_mss, size - offset);
+            OutstandingSegment piece{abs_seqno, seg.payload(), _now};
+            piece.payload.remove_prefix(offset);
+            piece.payload.remove_suffix(size - offset - piece_size);
+            piece.syn = seg.header().syn and offset == 0;
+            piece.fin = seg.header().fin and offset + piece_size == size;
+            abs_seqno += piece.length();
+            _outstanding.push_back(move(piece));
+        }
+    }
     _next_seqno += seg.length_in_sequence_space();
     _bytes_in_flight += seg.length_in_sequence_space();
     _segments_out.push(seg);
-    _segments_outstanding.push(seg);
     start_timer();
 }
 
+//! \param[in] abs_ackno an acknowledgment that falls strictly inside the oldest outstanding segment
+//! \details Drops the acknowledged prefix of the oldest outstanding segment, which no longer counts
+//! as in flight, so that a retransmission carries only the rest.
+void TCPSender::trim_outstanding_head(const uint64_t abs_ackno) {
+    auto &head = _outstanding.front();
+    const size_t acked = abs_ackno - head.abs_seqno;
+    _bytes_in_flight -= acked;
+    if (head.syn) {
+        head.syn = false;
+        head.payload.remove_prefix(acked - 1);
+    } else {
+        head.payload.remove_prefix(acked);
+    }
+    head.abs_seqno = abs_ackno;
+    head.payload_sum.reset();
+}
+
 void TCPSender::start_timer() {
     if (!_timer_running) {
         _timer_running = true;
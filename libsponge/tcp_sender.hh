@@ -3,12 +3,18 @@
 
 #include "buffer.hh"
 #include "byte_stream.hh"
+#include "rtt_estimator.hh"
+#include "tcp_congestion_control.hh"
 #include "tcp_config.hh"
 #include "tcp_segment.hh"
 #include "wrapping_integers.hh"
 
+#include <deque>
 #include <functional>
+#include <memory>
+#include <optional>
 #include <queue>
+#include <vector>
 
 /*
  * TCPSender Class
@@ -50,6 +56,10 @@ class TCPSender {
     unsigned int _initial_retransmission_timeout;
     unsigned int _current_rto;
 
+    //! Round-trip time estimates, and whether they set the retransmission timeout
+    RTTEstimator _rtt{};
+    bool _adaptive_rto{false};
+
     //! Outgoing stream of bytes
     ByteStream _stream;
 
@@ -59,10 +69,70 @@ class TCPSender {
     //! Connection state flags
     enum class State { CLOSED, SYN_SENT, SYN_ACKED, FIN_SENT } _state{State::CLOSED};
 
+    //! \brief The unacknowledged part of a segment that has been sent (or of one MSS of a GSO segment).
+    //! The header is rebuilt on retransmission.
+    struct OutstandingSegment {
+        uint64_t abs_seqno;                     //!< Absolute seqno of the first unacknowledged sequence number
+        Buffer payload;                         //!< Unacknowledged payload, sharing the sent segment's storage
+        uint64_t send_time;                     //!< Value of `_now` when the segment was last (re)transmitted
+        bool syn{false};                        //!< Does the segment still carry an unacknowledged SYN?
+        bool fin{false};                        //!< Does the segment carry FIN?
+        std::optional<uint16_t> payload_sum{};  //!< Ones' complement sum of `payload`, once known
+        bool retransmitted{false};              //!< Has the segment been sent more than once? (Karn's algorithm)
+        bool sacked{false};                     //!< Has the receiver selectively acknowledged the whole segment?
+
+        //! Number of sequence numbers the segment still occupies
+        size_t length() const { return payload.size() + syn + fin; }
+
+        //! Absolute seqno just past the end of the segment
+        uint64_t end() const { return abs_seqno + length(); }
+    };
+
     //! Sender window tracking
     uint64_t _bytes_in_flight = 0;
-    uint16_t _window_size{1};  // Start with 1 to allow sending SYN
-    std::queue<TCPSegment> _segments_outstanding{};
+    uint64_t _window_size{1};  // Start with 1 to allow sending SYN; already scaled by the peer's window scale
+
+    //! Scoreboard of outstanding segments, in sequence order. Each entry records its absolute
+    //! seqno so acknowledgments never need to unwrap the segments' headers.
+    std::deque<OutstandingSegment> _outstanding{};
+
+    //! Number of outstanding segments marked as SACKed, so that ACKs without SACK skip the scoreboard scan
+    size_t _sacked_segments{0};
+
+    //! Milliseconds elapsed since the sender was constructed
+    uint64_t _now{0};
+
+    //! Congestion control algorithm limiting the send window, or nullptr to send up to the receiver's window
+    TCPConfig::CongestionControl _congestion_algorithm;
+    std::unique_ptr<CongestionController> _congestion_control;
+
+    //! Largest payload of a segment on the wire, and how many of those one segment may hold (GSO)
+    size_t _mss{TCPConfig::MAX_PAYLOAD_SIZE};
+    unsigned _gso_segments{1};
+
+    //! Small segments held back by Nagle's algorithm or by a cork, unless flushing
+    bool _nagle{false};
+    bool _corked{false};
+    bool _flushing{false};
+
+    //! Pacing: segments of new data are sent only while the credit, refilled by tick(), is not in debt
+    static constexpr unsigned PACING_QUANTUM = 2;          //!< Segments the credit may always build up to
+    static constexpr unsigned PACING_BURST_MS = 1;         //!< Milliseconds of the rate the credit may build up to
+    static constexpr double PACING_GAIN_SLOW_START = 2.0;  //!< Derived rate, in windows per SRTT, in slow start
+    static constexpr double PACING_GAIN = 1.2;             //!< Derived rate, in windows per SRTT, otherwise
+    bool _pacing{false};                                   //!< Is pacing enabled?
+    std::optional<uint64_t> _configured_pacing_rate{};     //!< Fixed rate, in bytes per second
+    int64_t _pacing_credit{0};                             //!< Bytes that may still be sent; negative if in debt
+
+    //! Number of duplicate ACKs that make the sender retransmit without waiting for the timer
+    static constexpr unsigned DUPACK_THRESHOLD = 3;
+
+    //! Fast retransmit and NewReno fast recovery (RFC 6582)
+    unsigned _duplicate_acks{0};    //!< Duplicate ACKs received since the last ACK of new data
+    bool _in_fast_recovery{false};  //!< Is the sender recovering from a loss found by duplicate ACKs?
+    bool _fast_retransmit{false};   //!< Do duplicate ACKs retransmit, even without congestion control?
+    uint64_t _recovery_point{0};    //!< `_next_seqno` when the last loss was detected
+    size_t _recovery_inflation{0};  //!< Window inflation for segments that have left the network
 
     //! Retransmission tracking
     uint16_t _consecutive_retransmissions{0};
@@ -74,7 +144,16 @@ class TCPSender {
 
     //! Helper methods
     bool is_ack_valid(uint64_t abs_ackno) const;
+    bool is_duplicate_ack(const uint64_t abs_ackno, const uint64_t window_size) const;
+    void duplicate_ack_received(const uint64_t abs_ackno);
+    void recovery_ack_received(const uint64_t abs_ackno, const size_t acked_bytes);
+    void retransmit(OutstandingSegment &outstanding);
+    void retransmit_head();
+    bool sack_received(const uint64_t abs_ackno, const std::vector<SACKBlock> &sack);
+    void retransmit_sack_holes(const uint64_t abs_ackno);
     void send_segment(TCPSegment &seg);
+    bool hold_back(const size_t payload_size) const;
+    void trim_outstanding_head(const uint64_t abs_ackno);
     void start_timer();
     void stop_timer();
     void reset_timer();
@@ -83,7 +162,11 @@ class TCPSender {
     //! Initialize a TCPSender
     TCPSender(const size_t capacity = TCPConfig::DEFAULT_CAPACITY,
               const uint16_t retx_timeout = TCPConfig::TIMEOUT_DFLT,
-              const std::optional<WrappingInt32> fixed_isn = {});
+              const std::optional<WrappingInt32> fixed_isn = {},
+              const TCPConfig::CongestionControl congestion_control = TCPConfig::CongestionControl::NONE);
+
+    //! Initialize a TCPSender from a connection's configuration
+    explicit TCPSender(const TCPConfig &cfg);
 
     //! \name "Input" interface for the writer
     //!@{
@@ -95,16 +178,42 @@ class TCPSender {
     //!@{
 
     //! \brief A new acknowledgment was received
-    void ack_received(const WrappingInt32 ackno, const uint16_t window_size);
+    //! \param pure_ack false if the acknowledgment arrived on a segment that occupies sequence
+    //! space, so it cannot be counted as a duplicate ACK
+    //! \param window_size the receiver's window, after applying any window scale (\ref rfc::rfc7323 "RFC 7323")
+    //! \param sack blocks of data that the receiver holds beyond the ackno (\ref rfc::rfc2018 "RFC 2018")
+    //! \param tsecr the timestamp echoed with the acknowledgment (\ref rfc::rfc7323 "RFC 7323"), if any
+    void ack_received(const WrappingInt32 ackno,
+                      const uint64_t window_size,
+                      const bool pure_ack = true,
+                      const std::vector<SACKBlock> &sack = {},
+                      const std::optional<uint32_t> tsecr = std::nullopt);
 
     //! \brief Generate an empty-payload segment (useful for creating empty ACK segments)
     void send_empty_segment();
 
+    //! \brief Set the largest payload of a segment on the wire, e.g. from the MSS option in the peer's SYN
+    void set_mss(const size_t mss);
+
     //! \brief create and send segments to fill as much of the window as possible
     void fill_window();
 
+    //! \brief Fill the window, sending even the segments that Nagle's algorithm or a cork would hold back
+    void flush();
+
+    //! \brief Send only full segments until uncorked, as if every write announced more data to come
+    void cork() { _corked = true; }
+
+    //! \brief Stop holding back data for want of a full segment (call fill_window() to send it)
+    void uncork() { _corked = false; }
+
     //! \brief Notifies the TCPSender of the passage of time
     void tick(const size_t ms_since_last_tick);
+
+    //! \brief Milliseconds until tick() has something to do, or nothing if no timer is pending
+    //! \details That is the retransmission timer (which also paces zero-window probes), or the
+    //! refill of pacing credit that the sender is waiting for.
+    std::optional<size_t> time_until_next_timer() const;
     //!@}
 
     //! \name Accessors
@@ -118,6 +227,24 @@ class TCPSender {
     //! \brief Number of consecutive retransmissions that have occurred in a row
     unsigned int consecutive_retransmissions() const { return _consecutive_retransmissions; };
 
+    //! \brief Current retransmission timeout, in milliseconds, including any exponential backoff
+    unsigned int retransmission_timeout() const { return _current_rto; }
+
+    //! \brief Round-trip time estimates, from timestamp echoes or else from segments that were never retransmitted
+    const RTTEstimator &rtt_estimator() const { return _rtt; }
+
+    //! \brief Rate at which new data is paced, in bytes per second, or 0 if it is not paced (yet)
+    uint64_t pacing_rate() const;
+
+    //! \brief Largest payload of a segment on the wire. Segments in segments_out() may hold several (GSO).
+    size_t mss() const { return _mss; }
+
+    //! \brief TSval for a segment sent now: the sender's clock in milliseconds, modulo 2^32
+    uint32_t timestamp() const { return static_cast<uint32_t>(_now); }
+
+    //! \brief The congestion control algorithm in use, or nullptr if the sender only obeys the receiver's window
+    const CongestionController *congestion_control() const { return _congestion_control.get(); }
+
     //! \brief TCPSegments that the TCPSender has enqueued for transmission.
     //! \note These must be dequeued and sent by the TCPConnection,
     //! which will need to fill in the fields that are set by the TCPReceiver
@@ -2,12 +2,32 @@
 
 using namespace std;
 
+//! \details Every view of a Buffer keeps its whole storage alive, so a short payload that shares a large
+//! allocation would hold far more memory than flow control counts. Copying it once when at least half the
+//! allocation is spare bounds the memory kept to about twice the bytes.
+Buffer Buffer::compacted(string &&str) {
+    if (str.capacity() > 2 * str.size()) {
+        str.shrink_to_fit();
+    }
+    return Buffer{move(str)};
+}
+
 void Buffer::remove_prefix(const size_t n) {
     if (n > str().size()) {
         throw out_of_range("Buffer::remove_prefix");
     }
     _starting_offset += n;
-    if (_storage and _starting_offset == _storage->size()) {
+    if (_storage and _starting_offset + _ending_offset == _storage->size()) {
+        _storage.reset();
+    }
+}
+
+void Buffer::remove_suffix(const size_t n) {
+    if (n > str().size()) {
+        throw out_of_range("Buffer::remove_suffix");
+    }
+    _ending_offset += n;
+    if (_storage and _starting_offset + _ending_offset == _storage->size()) {
         _storage.reset();
     }
 }
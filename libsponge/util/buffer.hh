@@ -11,11 +11,12 @@
 #include <sys/uio.h>
 #include <vector>
 
-//! \brief A reference-counted read-only string that can discard bytes from the front
+//! \brief A reference-counted read-only string that can discard bytes from the front or back
 class Buffer {
   private:
     std::shared_ptr<std::string> _storage{};
     size_t _starting_offset{};
+    size_t _ending_offset{};  //!< Number of bytes discarded from the back of `_storage`
 
   public:
     Buffer() = default;
@@ -23,13 +24,17 @@ class Buffer {
     //! \brief Construct by taking ownership of a string
     Buffer(std::string &&str) noexcept : _storage(std::make_shared<std::string>(std::move(str))) {}
 
+    //! \brief Construct by taking ownership of a string, first releasing its spare capacity if it has more
+    //! spare than used (e.g. a datagram read into storage sized for the largest one)
+    static Buffer compacted(std::string &&str);
+
     //! \name Expose contents as a std::string_view
     //!@{
     std::string_view str() const {
         if (not _storage) {
             return {};
         }
-        return {_storage->data() + _starting_offset, _storage->size() - _starting_offset};
+        return {_storage->data() + _starting_offset, _storage->size() - _starting_offset - _ending_offset};
     }
 
     operator std::string_view() const { return str(); }
@@ -44,9 +49,16 @@ class Buffer {
     //! \brief Make a copy to a new std::string
     std::string copy() const { return std::string(str()); }
 
+    //! \brief Bytes allocated for the storage that this Buffer, and every other view of it, keeps alive
+    size_t storage_capacity() const { return _storage ? _storage->capacity() : 0; }
+
     //! \brief Discard the first `n` bytes of the string (does not require a copy or move)
     //! \note Doesn't free any memory until the whole string has been discarded in all copies of the Buffer.
     void remove_prefix(const size_t n);
+
+    //! \brief Discard the last `n` bytes of the string (does not require a copy or move)
+    //! \note Other copies of the Buffer still see the discarded bytes.
+    void remove_suffix(const size_t n);
 };
 
 //! \brief A reference-counted discontiguous string that can discard bytes from the front
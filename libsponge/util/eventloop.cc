@@ -2,6 +2,7 @@
 
 #include "util.hh"
 
+#include <algorithm>
 #include <cerrno>
 #include <stdexcept>
 #include <system_error>
@@ -10,6 +11,15 @@
 
 using namespace std;
 
+static_assert(static_cast<uint32_t>(Direction::In) == EPOLLIN and static_cast<uint32_t>(Direction::Out) == EPOLLOUT,
+              "Direction doubles as an epoll event mask");
+
+EventLoop::EventLoop(const Backend backend) : _backend(backend) {
+    if (_backend == Backend::Epoll) {
+        _epoll.emplace(SystemCall("epoll_create1", ::epoll_create1(EPOLL_CLOEXEC)));
+    }
+}
+
 unsigned int EventLoop::Rule::service_count() const {
     return direction == Direction::In ? fd.read_count() : fd.write_count();
 }
@@ -20,12 +30,64 @@ unsigned int EventLoop::Rule::service_count() const {
 //! \param[in] interest is called by EventLoop::wait_next_event. If it returns `true`, `fd` will
 //!                     be polled, otherwise `fd` will be ignored only for this execution of `wait_next_event.
 //! \param[in] cancel is called when the rule is cancelled (e.g. on hangup, EOF, or closure).
-void EventLoop::add_rule(const FileDescriptor &fd,
-                         const Direction direction,
-                         const CallbackT &callback,
-                         const InterestT &interest,
-                         const CallbackT &cancel) {
-    _rules.push_back({fd.duplicate(), direction, callback, interest, cancel});
+//! \returns a handle to pass to EventLoop::interest_changed
+EventLoop::RuleHandle EventLoop::add_rule(const FileDescriptor &fd,
+                                          const Direction direction,
+                                          const CallbackT &callback,
+                                          const InterestT &interest,
+                                          const CallbackT &cancel) {
+    const RuleHandle handle = _next_handle++;
+    if (_backend == Backend::Poll) {
+        _rules.push_back({fd.duplicate(), direction, callback, interest, cancel, handle});
+        return handle;
+    }
+
+    // A registration left behind by a closed file descriptor whose number has been reused is stale
+    const auto stale = _registrations.find(fd.fd_num());
+    if (stale != _registrations.end()) {
+        for (Rule *rule : {stale->second.in, stale->second.out}) {
+            if (rule and rule->fd.closed()) {
+                _epoll_cancel(_handles.at(rule->handle));
+            }
+        }
+    }
+
+    Registration &registration = _registrations[fd.fd_num()];
+    Rule *&slot = direction == Direction::In ? registration.in : registration.out;
+    if (slot) {
+        throw runtime_error("EventLoop: Backend::Epoll allows only one rule per file descriptor and direction");
+    }
+    if (not registration.in and not registration.out) {
+        epoll_event event{};
+        event.data.fd = fd.fd_num();
+        SystemCall("epoll_ctl", ::epoll_ctl(_epoll->fd_num(), EPOLL_CTL_ADD, fd.fd_num(), &event));
+    }
+
+    _rules.push_back({fd.duplicate(), direction, callback, interest, cancel, handle});
+    slot = &_rules.back();
+    _handles.emplace(handle, prev(_rules.end()));
+    _changed.push_back(handle);
+    return handle;
+}
+
+//! \param[in] handle the rule, as returned by EventLoop::add_rule
+//! \details With Backend::Poll every rule's interest is evaluated on every wait anyway, so this does nothing.
+void EventLoop::interest_changed(const RuleHandle handle) {
+    if (_backend == Backend::Epoll) {
+        _changed.push_back(handle);
+    }
+}
+
+void EventLoop::interest_changed() {
+    if (_backend == Backend::Epoll) {
+        for (const auto &rule : _rules) {
+            _changed.push_back(rule.handle);
+        }
+    }
+}
+
+EventLoop::Result EventLoop::wait_next_event(const int timeout_ms) {
+    return _backend == Backend::Epoll ? _epoll_wait_next_event(timeout_ms) : _poll_wait_next_event(timeout_ms);
 }
 
 //! \param[in] timeout_ms is the timeout value passed to [poll(2)](\ref man2::poll); `wait_next_event`
@@ -58,7 +120,7 @@ void EventLoop::add_rule(const FileDescriptor &fd,
 //! because [poll(2)](\ref man2::poll) is level triggered, so failing to act on a ready file descriptor
 //! will result in a busy loop (poll returns on a ready file descriptor; file descriptor is not read or
 //! written, so it is still ready; the next call to poll will immediately return).
-EventLoop::Result EventLoop::wait_next_event(const int timeout_ms) {
+EventLoop::Result EventLoop::_poll_wait_next_event(const int timeout_ms) {
     vector<pollfd> pollfds{};
     pollfds.reserve(_rules.size());
     bool something_to_poll = false;
@@ -117,10 +179,12 @@ EventLoop::Result EventLoop::wait_next_event(const int timeout_ms) {
         const auto &this_rule = *it;
         const auto poll_ready = static_cast<bool>(this_pollfd.revents & this_pollfd.events);
         const auto poll_hup = static_cast<bool>(this_pollfd.revents & POLLHUP);
-        if (poll_hup && this_pollfd.events && !poll_ready) {
+        if (poll_hup && !poll_ready && (this_pollfd.events || this_rule.direction == Direction::Out)) {
             // if we asked for the status, and the _only_ condition was a hangup, this FD is defunct:
             //   - if it was POLLIN and nothing is readable, no more will ever be readable
             //   - if it was POLLOUT, it will not be writable again
+            // a POLLOUT rule is canceled even if we didn't ask, since it can never run again and
+            // the hangup would otherwise end every poll at once
             this_rule.cancel();
             it = _rules.erase(it);
             continue;
@@ -143,3 +207,157 @@ EventLoop::Result EventLoop::wait_next_event(const int timeout_ms) {
 
     return Result::Success;
 }
+
+//! \param[in] fd_num the file descriptor whose rules' interest may have changed
+void EventLoop::_epoll_update(const int fd_num) {
+    Registration &registration = _registrations.at(fd_num);
+    uint32_t events = 0;
+    for (const Rule *rule : {registration.in, registration.out}) {
+        if (rule and rule->interested) {
+            events |= static_cast<uint32_t>(rule->direction);
+        }
+    }
+    if (events != registration.events) {
+        epoll_event event{};
+        event.events = events;
+        event.data.fd = fd_num;
+        SystemCall("epoll_ctl", ::epoll_ctl(_epoll->fd_num(), EPOLL_CTL_MOD, fd_num, &event));
+        registration.events = events;
+    }
+}
+
+//! \param[in] rule the rule to cancel, which is deleted
+//! \details The kernel drops a file descriptor from the epoll set by itself once it is closed.
+void EventLoop::_epoll_cancel(const list<Rule>::iterator rule) {
+    const int fd_num = rule->fd.fd_num();
+    Registration &registration = _registrations.at(fd_num);
+    (rule->direction == Direction::In ? registration.in : registration.out) = nullptr;
+    if (rule->interested) {
+        rule->interested = false;
+        _interested_rules--;
+    }
+
+    if (not registration.in and not registration.out) {
+        if (not rule->fd.closed()) {
+            SystemCall("epoll_ctl", ::epoll_ctl(_epoll->fd_num(), EPOLL_CTL_DEL, fd_num, nullptr));
+        }
+        _registrations.erase(fd_num);
+    } else if (not rule->fd.closed()) {
+        _epoll_update(fd_num);
+    }
+
+    _handles.erase(rule->handle);
+    rule->cancel();
+    _rules.erase(rule);
+}
+
+//! \param[in] handle the rule whose interest may have changed; ignored if it was canceled since
+void EventLoop::_epoll_refresh(const RuleHandle handle) {
+    const auto found = _handles.find(handle);
+    if (found == _handles.end()) {
+        return;
+    }
+
+    Rule &rule = *found->second;
+    if (rule.fd.closed()) {
+        // cancel the rule for the other direction too, since its registration is gone with the fd
+        const Registration &registration = _registrations.at(rule.fd.fd_num());
+        Rule *other = rule.direction == Direction::In ? registration.out : registration.in;
+        _epoll_cancel(found->second);
+        if (other) {
+            _epoll_cancel(_handles.at(other->handle));
+        }
+        return;
+    }
+    if (rule.direction == Direction::In and rule.fd.eof()) {
+        // no more reading on this rule, it's reached eof
+        _epoll_cancel(found->second);
+        return;
+    }
+
+    const bool interested = rule.interest();
+    if (interested != rule.interested) {
+        rule.interested = interested;
+        if (interested) {
+            _interested_rules++;
+        } else {
+            _interested_rules--;
+        }
+        _epoll_update(rule.fd.fd_num());
+    }
+}
+
+//! \param[in] timeout_ms is the timeout value passed to [epoll_wait(2)](\ref man2::epoll_wait)
+//! \returns Eventloop::Result, exactly as EventLoop::wait_next_event does with Backend::Poll
+//!
+//! This function first re-evaluates the interest of the rules that were added, that ran, or that
+//! were passed to EventLoop::interest_changed since the last wait, changing the epoll set only where
+//! a rule's interest changed. Then it waits, and calls the callbacks of the rules whose file descriptors
+//! are ready, under the same rules as with Backend::Poll for errors, hangups and busy waits.
+EventLoop::Result EventLoop::_epoll_wait_next_event(const int timeout_ms) {
+    vector<RuleHandle> changed{};
+    swap(changed, _changed);
+    for (const RuleHandle handle : changed) {
+        _epoll_refresh(handle);
+    }
+
+    // quit if there is nothing left to wait for
+    if (_interested_rules == 0) {
+        return Result::Exit;
+    }
+
+    _ready_events.resize(max<size_t>(_registrations.size(), 1));
+    int ready_count = 0;
+    try {
+        ready_count = SystemCall("epoll_wait",
+                                 ::epoll_wait(_epoll->fd_num(), _ready_events.data(), _ready_events.size(), timeout_ms));
+    } catch (unix_error const &e) {
+        if (e.code().value() == EINTR) {
+            return Result::Exit;
+        }
+        throw;
+    }
+    if (ready_count == 0) {
+        return Result::Timeout;
+    }
+
+    for (int i = 0; i < ready_count; i++) {
+        const epoll_event &event = _ready_events[i];
+        if (event.events & EPOLLERR) {
+            throw runtime_error("EventLoop: error on polled file descriptor");
+        }
+
+        for (const Direction direction : {Direction::In, Direction::Out}) {
+            // an earlier callback may have closed the file descriptor
+            const auto registration = _registrations.find(event.data.fd);
+            if (registration == _registrations.end()) {
+                break;
+            }
+            Rule *rule = direction == Direction::In ? registration->second.in : registration->second.out;
+            if (not rule or rule->fd.closed()) {
+                continue;
+            }
+
+            const bool ready = rule->interested and (event.events & static_cast<uint32_t>(direction));
+            if (not ready) {
+                // hangup, and nothing to read or room to write: this FD is defunct (and, as with
+                // Backend::Poll, an uninterested Out rule is canceled since it can never run again)
+                if ((event.events & EPOLLHUP) and (rule->interested or direction == Direction::Out)) {
+                    _epoll_cancel(_handles.at(rule->handle));
+                }
+                continue;
+            }
+
+            const auto count_before = rule->service_count();
+            rule->callback();
+
+            if (count_before == rule->service_count() and rule->interest()) {
+                throw runtime_error(
+                    "EventLoop: busy wait detected: callback did not read/write fd and is still interested");
+            }
+            _changed.push_back(rule->handle);
+        }
+    }
+
+    return Result::Success;
+}
@@ -3,10 +3,15 @@
 
 #include "file_descriptor.hh"
 
+#include <cstdint>
 #include <cstdlib>
 #include <functional>
 #include <list>
+#include <optional>
 #include <poll.h>
+#include <sys/epoll.h>
+#include <unordered_map>
+#include <vector>
 
 //! Waits for events on file descriptors and executes corresponding callbacks.
 class EventLoop {
@@ -17,6 +22,15 @@ class EventLoop {
         Out = POLLOUT  //!< Callback will be triggered when Rule::fd is writable.
     };
 
+    //! How the EventLoop waits for file descriptors to become ready.
+    enum class Backend {
+        Poll,  //!< Rebuild a [poll(2)](\ref man2::poll) set from every rule's interest on every wait.
+        Epoll  //!< Keep an [epoll(7)](\ref man7::epoll) set, changed only for rules whose interest may have changed.
+    };
+
+    //! Identifies a rule, e.g. to tell the EventLoop that its interest may have changed.
+    using RuleHandle = uint64_t;
+
   private:
     using CallbackT = std::function<void(void)>;  //!< Callback for ready Rule::fd
     using InterestT = std::function<bool(void)>;  //!< `true` return indicates Rule::fd should be polled.
@@ -30,6 +44,8 @@ class EventLoop {
         CallbackT callback;   //!< A callback that reads or writes fd.
         InterestT interest;   //!< A callback that returns `true` whenever fd should be polled.
         CallbackT cancel;     //!< A callback that is called when the rule is cancelled (e.g. on hangup)
+        RuleHandle handle;    //!< Identifies the rule to EventLoop::interest_changed.
+        bool interested{};    //!< Last value returned by Rule::interest (Backend::Epoll only).
 
         //! Returns the number of times fd has been read or written, depending on the value of Rule::direction.
         //! \details This function is used internally by EventLoop; you will not need to call it
@@ -38,6 +54,27 @@ class EventLoop {
 
     std::list<Rule> _rules{};  //!< All rules that have been added and not canceled.
 
+    Backend _backend;            //!< How the EventLoop waits for file descriptors.
+    RuleHandle _next_handle{0};  //!< Handle of the next rule to be added.
+
+    //! The rules watching one file descriptor, and the events the epoll set holds for it.
+    struct Registration {
+        Rule *in{nullptr};   //!< The Direction::In rule, if any.
+        Rule *out{nullptr};  //!< The Direction::Out rule, if any.
+        uint32_t events{0};  //!< Events the epoll set waits for on this file descriptor.
+    };
+
+    //! \name State of Backend::Epoll
+    //!@{
+    std::optional<FileDescriptor> _epoll{};                                //!< The epoll instance.
+    std::unordered_map<int, Registration> _registrations{};                //!< Registrations by fd number.
+    std::unordered_map<RuleHandle, std::list<Rule>::iterator> _handles{};  //!< Rules by handle.
+
+    std::vector<RuleHandle> _changed{};        //!< Rules whose interest must be re-evaluated before waiting.
+    size_t _interested_rules{0};               //!< Number of rules whose Rule::interested is `true`.
+    std::vector<epoll_event> _ready_events{};  //!< Buffer for [epoll_wait(2)](\ref man2::epoll_wait).
+    //!@}
+
   public:
     //! Returned by each call to EventLoop::wait_next_event.
     enum class Result {
@@ -46,8 +83,11 @@ class EventLoop {
         Exit  //!< All rules have been canceled or were uninterested; make no further calls to EventLoop::wait_next_event.
     };
 
+    //! \param[in] backend how to wait for file descriptors to become ready
+    explicit EventLoop(const Backend backend = Backend::Poll);
+
     //! Add a rule whose callback will be called when `fd` is ready in the specified Direction.
-    void add_rule(
+    RuleHandle add_rule(
         const FileDescriptor &fd,
         const Direction direction,
         const CallbackT &callback,
@@ -56,6 +96,23 @@ class EventLoop {
 
     //! Calls [poll(2)](\ref man2::poll) and then executes callback for each ready fd.
     Result wait_next_event(const int timeout_ms);
+
+    //! Re-evaluate the rule's interest before the next wait (needed only with Backend::Epoll).
+    void interest_changed(const RuleHandle handle);
+
+    //! Re-evaluate every rule's interest before the next wait (needed only with Backend::Epoll).
+    void interest_changed();
+
+  private:
+    Result _poll_wait_next_event(const int timeout_ms);
+
+    //! \name Backend::Epoll helpers
+    //!@{
+    Result _epoll_wait_next_event(const int timeout_ms);
+    void _epoll_refresh(const RuleHandle handle);              //!< Re-evaluate a rule's interest, or cancel it
+    void _epoll_update(const int fd_num);                      //!< Bring the epoll set up to date for `fd_num`
+    void _epoll_cancel(const std::list<Rule>::iterator rule);  //!< Cancel a rule and forget its registration
+    //!@}
 };
 
 using Direction = EventLoop::Direction;
@@ -73,5 +130,12 @@ using Direction = EventLoop::Direction;
 //! A Rule installed using EventLoop::add_cancelable_rule will be polled and canceled under the
 //! same conditions, with the additional condition that if Rule::callback returns `true`, the
 //! Rule will be canceled.
+//!
+//! With Backend::Epoll, file descriptors stay registered with the kernel between waits, and each
+//! wait costs time in proportion to the number of ready file descriptors rather than the number of
+//! rules. In exchange, Rule::interest is only called when a rule is added, after its own callback
+//! runs, and after EventLoop::interest_changed. Code that changes what another rule is interested
+//! in (for instance, a callback that queues data for a different rule to write) must call
+//! EventLoop::interest_changed. Each file descriptor may have at most one rule per Direction.
 
 #endif  // SPONGE_LIBSPONGE_EVENTLOOP_HH
@@ -3,8 +3,10 @@
 #include "util.hh"
 
 #include <algorithm>
+#include <cerrno>
 #include <fcntl.h>
 #include <iostream>
+#include <poll.h>
 #include <stdexcept>
 #include <sys/uio.h>
 #include <unistd.h>
@@ -47,11 +49,26 @@ FileDescriptor FileDescriptor::duplicate() const { return FileDescriptor(_intern
 //! \param[in] limit is the maximum number of bytes to read; fewer bytes may be returned
 //! \param[out] str is the string to be read
 void FileDescriptor::read(std::string &str, const size_t limit) {
+    if (not try_read(str, limit)) {
+        throw unix_error("read", EAGAIN);
+    }
+}
+
+//! \param[in] limit is the maximum number of bytes to read; fewer bytes may be returned
+//! \param[out] str is the string to be read, left empty if nothing could be read without blocking
+//! \details Only a non-blocking fd (see set_blocking()) can return `false`; a blocking one waits, as read() does.
+//! A read that would have blocked still counts towards read_count(), since the caller did service the fd.
+bool FileDescriptor::try_read(std::string &str, const size_t limit) {
     constexpr size_t BUFFER_SIZE = 1024 * 1024;  // maximum size of a read
     const size_t size_to_read = min(BUFFER_SIZE, limit);
     str.resize(size_to_read);
 
-    ssize_t bytes_read = SystemCall("read", ::read(fd_num(), str.data(), size_to_read));
+    ssize_t bytes_read = SystemCall("read", ::read(fd_num(), str.data(), size_to_read), EAGAIN);
+    if (bytes_read < 0) {
+        str.clear();
+        register_read();
+        return false;
+    }
     if (limit > 0 && bytes_read == 0) {
         _internal_fd->_eof = true;
     }
@@ -61,6 +78,7 @@ void FileDescriptor::read(std::string &str, const size_t limit) {
     str.resize(bytes_read);
 
     register_read();
+    return true;
 }
 
 //! \param[in] limit is the maximum number of bytes to read; fewer bytes may be returned
@@ -108,3 +126,8 @@ void FileDescriptor::set_blocking(const bool blocking_state) {
 
     SystemCall("fcntl", fcntl(fd_num(), F_SETFL, flags));
 }
+
+bool FileDescriptor::readable() const {
+    pollfd pfd{fd_num(), POLLIN, 0};
+    return SystemCall("poll", ::poll(&pfd, 1, 0)) > 0 and (pfd.revents & POLLIN);
+}
@@ -4,6 +4,7 @@
 #include "buffer.hh"
 
 #include <array>
+#include <atomic>
 #include <cstddef>
 #include <limits>
 #include <memory>
@@ -14,11 +15,11 @@ class FileDescriptor {
     //! \details FileDescriptor objects contain a std::shared_ptr to a FDWrapper.
     class FDWrapper {
       public:
-        int _fd;                    //!< The file descriptor number returned by the kernel
-        bool _eof = false;          //!< Flag indicating whether FDWrapper::_fd is at EOF
-        bool _closed = false;       //!< Flag indicating whether FDWrapper::_fd has been closed
-        unsigned _read_count = 0;   //!< The number of times FDWrapper::_fd has been read
-        unsigned _write_count = 0;  //!< The numberof times FDWrapper::_fd has been written
+        int _fd;                                //!< The file descriptor number returned by the kernel
+        bool _eof = false;                      //!< Flag indicating whether FDWrapper::_fd is at EOF
+        bool _closed = false;                   //!< Flag indicating whether FDWrapper::_fd has been closed
+        std::atomic<unsigned> _read_count{0};   //!< The number of times FDWrapper::_fd has been read
+        std::atomic<unsigned> _write_count{0};  //!< The numberof times FDWrapper::_fd has been written
 
         //! Construct from a file descriptor number returned by the kernel
         explicit FDWrapper(const int fd);
@@ -61,6 +62,10 @@ class FileDescriptor {
     //! Read up to `limit` bytes into `str` (caller can allocate storage)
     void read(std::string &str, const size_t limit = std::numeric_limits<size_t>::max());
 
+    //! Read up to `limit` bytes into `str`, unless nothing can be read without blocking
+    //! \returns `false` if the fd is non-blocking and had nothing to read
+    bool try_read(std::string &str, const size_t limit = std::numeric_limits<size_t>::max());
+
     //! Write a string, possibly blocking until all is written
     size_t write(const char *str, const bool write_all = true) { return write(BufferViewList(str), write_all); }
 
@@ -79,6 +84,9 @@ class FileDescriptor {
     //! Set blocking(true) or non-blocking(false)
     void set_blocking(const bool blocking_state);
 
+    //! Could the fd be read right now without blocking?
+    bool readable() const;
+
     //! \name FDWrapper accessors
     //!@{
     int fd_num() const { return _internal_fd->_fd; }                         //!< \brief underlying descriptor number
@@ -101,6 +109,8 @@ class FileDescriptor {
 //! \class FileDescriptor
 //! In addition, FileDescriptor tracks EOF state and calls to FileDescriptor::read and
 //! FileDescriptor::write, which EventLoop uses to detect busy loop conditions.
+//! The counts are atomic, so that threads sharing a file descriptor (e.g., the shards
+//! of a ShardedTCPStack writing to one socket) can each read or write it.
 //!
 //! For an example of FileDescriptor use, see the EventLoop class documentation.
 
@@ -2,6 +2,7 @@
 
 #include "util.hh"
 
+#include <cerrno>
 #include <cstddef>
 #include <stdexcept>
 #include <unistd.h>
@@ -86,24 +87,49 @@ void Socket::shutdown(const int how) {
 
 //! \note If `mtu` is too small to hold the received datagram, this method throws a std::runtime_error
 void UDPSocket::recv(received_datagram &datagram, const size_t mtu) {
+    if (not _recv(datagram, mtu, 0)) {
+        throw unix_error("recvfrom", EAGAIN);
+    }
+}
+
+//! \details Unlike FileDescriptor::try_read(), this works whether or not the socket is blocking, since it passes
+//! MSG_DONTWAIT to [recvfrom(2)](\ref man2::recvfrom) instead of relying on the socket's flags.
+//! \note If `mtu` is too small to hold the received datagram, this method throws a std::runtime_error
+bool UDPSocket::try_recv(received_datagram &datagram, const size_t mtu) { return _recv(datagram, mtu, MSG_DONTWAIT); }
+
+//! \param[out] datagram is the datagram received, with its payload left empty if none was waiting
+//! \param[in] mtu is the largest payload that can be received
+//! \param[in] flags are passed to [recvfrom(2)](\ref man2::recvfrom)
+//! \returns `false` if the socket had no datagram and `flags` asked not to wait for one
+bool UDPSocket::_recv(received_datagram &datagram, const size_t mtu, const int flags) {
     // receive source address and payload
     Address::Raw datagram_source_address;
     datagram.payload.resize(mtu);
 
     socklen_t fromlen = sizeof(datagram_source_address);
 
-    const ssize_t recv_len = SystemCall(
-        "recvfrom",
-        ::recvfrom(
-            fd_num(), datagram.payload.data(), datagram.payload.size(), MSG_TRUNC, datagram_source_address, &fromlen));
+    const ssize_t recv_len = SystemCall("recvfrom",
+                                        ::recvfrom(fd_num(),
+                                                   datagram.payload.data(),
+                                                   datagram.payload.size(),
+                                                   MSG_TRUNC | flags,
+                                                   datagram_source_address,
+                                                   &fromlen),
+                                        EAGAIN);
+
+    register_read();
+    if (recv_len < 0) {
+        datagram.payload.clear();
+        return false;
+    }
 
     if (recv_len > ssize_t(mtu)) {
         throw runtime_error("recvfrom (oversized datagram)");
     }
 
-    register_read();
     datagram.source_address = {datagram_source_address, fromlen};
     datagram.payload.resize(recv_len);
+    return true;
 }
 
 UDPSocket::received_datagram UDPSocket::recv(const size_t mtu) {
@@ -70,11 +70,19 @@ class UDPSocket : public Socket {
     //! Receive a datagram and the Address of its sender (caller can allocate storage)
     void recv(received_datagram &datagram, const size_t mtu = 65536);
 
+    //! Receive a datagram and the Address of its sender, unless none is waiting
+    //! \returns `false` if no datagram was waiting
+    bool try_recv(received_datagram &datagram, const size_t mtu = 65536);
+
     //! Send a datagram to specified Address
     void sendto(const Address &destination, const BufferViewList &payload);
 
     //! Send datagram to the socket's connected address (must call connect() first)
     void send(const BufferViewList &payload);
+
+  private:
+    //! Receive a datagram with [recvfrom(2)](\ref man2::recvfrom) `flags`
+    bool _recv(received_datagram &datagram, const size_t mtu, const int flags);
 };
 
 //! \class UDPSocket
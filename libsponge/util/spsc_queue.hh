@@ -0,0 +1,55 @@
+#ifndef SPONGE_LIBSPONGE_SPSC_QUEUE_HH
+#define SPONGE_LIBSPONGE_SPSC_QUEUE_HH
+
+#include <atomic>
+#include <cstddef>
+#include <optional>
+#include <utility>
+#include <vector>
+
+//! \brief A bounded, lock-free queue between one producer thread and one consumer thread
+
+//! The producer calls only push(), and the consumer calls only pop(). Each index is written
+//! by one thread and read by the other, and the two are kept on separate cache lines so that
+//! the threads do not contend for the line that holds them.
+template <typename T>
+class SPSCQueue {
+  private:
+    static constexpr size_t CACHE_LINE = 64;
+
+    std::vector<std::optional<T>> _slots;              //!< One more slot than the capacity, to tell full from empty
+    alignas(CACHE_LINE) std::atomic<size_t> _head{0};  //!< Next slot to pop (written by the consumer)
+    alignas(CACHE_LINE) std::atomic<size_t> _tail{0};  //!< Next slot to push (written by the producer)
+
+  public:
+    //! \param[in] capacity is the most items that the queue holds
+    explicit SPSCQueue(const size_t capacity) : _slots(capacity + 1) {}
+
+    //! \brief Append an item (producer only)
+    //! \returns false, leaving `item` unchanged, if the queue is full
+    bool push(T &&item) {
+        const size_t tail = _tail.load(std::memory_order_relaxed);
+        const size_t next = tail + 1 == _slots.size() ? 0 : tail + 1;
+        if (next == _head.load(std::memory_order_acquire)) {
+            return false;
+        }
+        _slots[tail].emplace(std::move(item));
+        _tail.store(next, std::memory_order_release);
+        return true;
+    }
+
+    //! \brief Remove the oldest item (consumer only)
+    //! \returns the item, or nothing if the queue is empty
+    std::optional<T> pop() {
+        const size_t head = _head.load(std::memory_order_relaxed);
+        if (head == _tail.load(std::memory_order_acquire)) {
+            return {};
+        }
+        std::optional<T> item{};
+        item.swap(_slots[head]);  // leaves the slot empty
+        _head.store(head + 1 == _slots.size() ? 0 : head + 1, std::memory_order_release);
+        return item;
+    }
+};
+
+#endif  // SPONGE_LIBSPONGE_SPSC_QUEUE_HH
@@ -0,0 +1,201 @@
+#ifndef SPONGE_LIBSPONGE_TIMING_WHEEL_HH
+#define SPONGE_LIBSPONGE_TIMING_WHEEL_HH
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+//! \brief A hierarchical timing wheel (Varghese and Lauck) that holds at most one timer per key
+
+//! Times are in ticks, e.g. milliseconds. Level 0 has one slot for each of the next SLOTS ticks.
+//! Each level above it has slots SLOTS times as wide. When time reaches a wide slot, its timers
+//! move down to narrower levels. Scheduling, rescheduling and canceling a timer take constant time.
+//! advance() visits only the ticks that have a level-0 timer, plus one tick in every SLOTS if higher
+//! levels hold timers, and does constant work per timer each time the timer moves down a level.
+//! An idle key costs nothing until its timer fires.
+//!
+//! A timer fires at the first advance() to its deadline or later. Deadlines more than HORIZON
+//! ticks ahead are brought forward to HORIZON ticks ahead.
+template <typename Key, typename Hash = std::hash<Key>>
+class TimingWheel {
+  public:
+    static constexpr unsigned SLOT_BITS = 6;                 //!< log2 of the number of slots per level
+    static constexpr size_t SLOTS = size_t{1} << SLOT_BITS;  //!< Slots per level (one bit each in a uint64_t)
+    static constexpr unsigned LEVELS = 4;                    //!< Number of levels
+
+    //! Furthest deadline that the wheel holds, in ticks from now
+    static constexpr uint64_t HORIZON = (uint64_t{1} << (SLOT_BITS * LEVELS)) - 1;
+
+  private:
+    //! Where a key's timer is
+    struct Timer {
+        uint64_t deadline{0};
+        unsigned level{0};
+        size_t slot{0};
+        typename std::list<Key>::iterator position{};
+    };
+
+    std::array<std::array<std::list<Key>, SLOTS>, LEVELS> _slots{};  //!< Keys in each slot of each level
+    std::array<uint64_t, LEVELS> _occupied{};                        //!< Bit `i` is set if slot `i` holds a key
+    std::unordered_map<Key, Timer, Hash> _timers{};                  //!< Timers by key
+    uint64_t _now;                                                   //!< Current time; every timer expires after it
+
+    //! Width of a slot of `level`, in ticks
+    static constexpr uint64_t width(const unsigned level) { return uint64_t{1} << (SLOT_BITS * level); }
+
+    //! Move a key's timer out of list `from` (or, if `from` is null, insert it) into the slot for its deadline
+    void place(const Key &key, Timer &timer, std::list<Key> *from) {
+        const uint64_t delta = timer.deadline - _now;
+        unsigned level = 0;
+        while (level + 1 < LEVELS and delta >= width(level + 1)) {
+            level++;
+        }
+        const size_t slot = (timer.deadline / width(level)) % SLOTS;
+
+        std::list<Key> &to = _slots[level][slot];
+        if (from) {
+            to.splice(to.end(), *from, timer.position);
+        } else {
+            timer.position = to.insert(to.end(), key);
+        }
+        timer.level = level;
+        timer.slot = slot;
+        _occupied[level] |= uint64_t{1} << slot;
+    }
+
+    //! Clear the occupied bit of a slot that may have become empty
+    void update_occupied(const unsigned level, const size_t slot) {
+        if (_slots[level][slot].empty()) {
+            _occupied[level] &= ~(uint64_t{1} << slot);
+        }
+    }
+
+    //! The first tick after now that holds a level-0 timer, if any
+    std::optional<uint64_t> next_level0() const {
+        if (_occupied[0] == 0) {
+            return {};
+        }
+        // level 0 holds deadlines in (now, now + SLOTS), so rotate the bit for now + 1 to the bottom
+        const unsigned offset = (_now + 1) % SLOTS;
+        const uint64_t bits = _occupied[0];
+        const uint64_t rotated = offset == 0 ? bits : (bits >> offset) | (bits << (SLOTS - offset));
+        return _now + 1 + __builtin_ctzll(rotated);
+    }
+
+    //! The next tick after now at which higher levels move timers down, if they hold any
+    std::optional<uint64_t> next_cascade() const {
+        for (unsigned level = 1; level < LEVELS; level++) {
+            if (_occupied[level]) {
+                return (_now / SLOTS + 1) * SLOTS;
+            }
+        }
+        return {};
+    }
+
+  public:
+    //! \param[in] now is the current time
+    explicit TimingWheel(const uint64_t now = 0) : _now(now) {}
+
+    //! \brief Set the timer of `key` to fire at `deadline`, replacing any timer it had
+    void schedule(const Key &key, const uint64_t deadline) {
+        const uint64_t clamped = std::clamp(deadline, _now + 1, _now + HORIZON);
+        auto [it, inserted] = _timers.try_emplace(key);
+        Timer &timer = it->second;
+        if (not inserted and timer.deadline == clamped) {
+            return;
+        }
+
+        std::list<Key> *from = inserted ? nullptr : &_slots[timer.level][timer.slot];
+        const unsigned old_level = timer.level;
+        const size_t old_slot = timer.slot;
+        timer.deadline = clamped;
+        place(it->first, timer, from);
+        if (not inserted) {
+            update_occupied(old_level, old_slot);
+        }
+    }
+
+    //! \brief Remove the timer of `key`, if it has one
+    void cancel(const Key &key) {
+        auto it = _timers.find(key);
+        if (it == _timers.end()) {
+            return;
+        }
+        const Timer &timer = it->second;
+        _slots[timer.level][timer.slot].erase(timer.position);
+        update_occupied(timer.level, timer.slot);
+        _timers.erase(it);
+    }
+
+    //! \brief Advance the current time, removing the timers that expire by then
+    //! \param[in] now is the new current time (earlier times are ignored)
+    //! \param[out] expired has the keys of the expired timers appended, in order of their deadlines
+    void advance(const uint64_t now, std::vector<Key> &expired) {
+        while (_now < now) {
+            if (_timers.empty()) {
+                _now = now;
+                return;
+            }
+
+            // jump to the next tick with anything to do
+            uint64_t next = now;
+            for (const auto &candidate : {next_level0(), next_cascade()}) {
+                if (candidate) {
+                    next = std::min(next, candidate.value());
+                }
+            }
+            _now = next;
+
+            // move down the timers of the wide slots that start now, from the widest
+            for (unsigned level = LEVELS - 1; level > 0; level--) {
+                if (_now % width(level) != 0) {
+                    continue;
+                }
+                const size_t slot = (_now / width(level)) % SLOTS;
+                std::list<Key> moving{};
+                moving.splice(moving.end(), _slots[level][slot]);
+                _occupied[level] &= ~(uint64_t{1} << slot);
+                while (not moving.empty()) {
+                    place(moving.front(), _timers.at(moving.front()), &moving);
+                }
+            }
+
+            // every level-0 timer in the slot for now has its deadline now
+            const size_t slot = _now % SLOTS;
+            for (const Key &key : _slots[0][slot]) {
+                expired.push_back(key);
+                _timers.erase(key);
+            }
+            _slots[0][slot].clear();
+            _occupied[0] &= ~(uint64_t{1} << slot);
+        }
+    }
+
+    //! \brief When advance() should next be called to fire timers on time
+    //! \returns a time no later than the earliest deadline, or nothing if there are no timers
+    std::optional<uint64_t> next_expiry() const {
+        const auto level0 = next_level0();
+        const auto cascade = next_cascade();
+        if (level0 and cascade) {
+            return std::min(level0.value(), cascade.value());
+        }
+        return level0 ? level0 : cascade;
+    }
+
+    //! The current time
+    uint64_t now() const { return _now; }
+
+    //! Number of timers
+    size_t size() const { return _timers.size(); }
+
+    //! Does `key` have a timer?
+    bool scheduled(const Key &key) const { return _timers.count(key) > 0; }
+};
+
+#endif  // SPONGE_LIBSPONGE_TIMING_WHEEL_HH
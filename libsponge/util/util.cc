@@ -3,19 +3,35 @@
 #include <array>
 #include <cctype>
 #include <chrono>
+#include <cstring>
+#include <endian.h>
 #include <iomanip>
 #include <iostream>
 #include <sstream>
+#include <stdexcept>
 #include <sys/socket.h>
 
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
 using namespace std;
 
-//! \returns the number of milliseconds since the program started
-uint64_t timestamp_ms() {
+//! \returns the time elapsed since the program started (strictly, since the first call)
+static std::chrono::steady_clock::duration time_since_program_start() {
     using time_point = std::chrono::steady_clock::time_point;
     static const time_point program_start = std::chrono::steady_clock::now();
-    const time_point now = std::chrono::steady_clock::now();
-    return std::chrono::duration_cast<std::chrono::milliseconds>(now - program_start).count();
+    return std::chrono::steady_clock::now() - program_start;
+}
+
+//! \returns the number of milliseconds since the program started
+uint64_t timestamp_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(time_since_program_start()).count();
+}
+
+//! \returns the number of microseconds since the program started
+uint64_t timestamp_us() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(time_since_program_start()).count();
 }
 
 //! \param[in] attempt is the name of the syscall to try (for error reporting)
@@ -84,17 +100,152 @@ mt19937 get_random_generator() {
 //!
 //! For more information, see the [Wikipedia page](https://en.wikipedia.org/wiki/IPv4_header_checksum)
 //! on the Internet checksum, and consult the [IP](\ref rfc::rfc791) and [TCP](\ref rfc::rfc793) RFCs.
-InternetChecksum::InternetChecksum(const uint32_t initial_sum) : _sum(initial_sum) {}
+InternetChecksum::InternetChecksum(const uint32_t initial_sum, const Kernel kernel)
+    : _sum(initial_sum), _kernel(kernel) {
+    if (not supported(kernel)) {
+        throw runtime_error("InternetChecksum: kernel not supported on this CPU");
+    }
+}
 
-void InternetChecksum::add(std::string_view data) {
-    for (size_t i = 0; i < data.size(); i++) {
-        uint16_t val = uint8_t(data[i]);
-        if (not _parity) {
-            val <<= 8;
+//! \returns `sum + x` in ones' complement arithmetic (i.e., with the carry wrapped around)
+static inline uint64_t add_with_carry(uint64_t sum, const uint64_t x) {
+    sum += x;
+    return sum + (sum < x);
+}
+
+//! \returns `sum` folded to 16 bits without changing its value in ones' complement arithmetic
+static inline uint16_t fold_sum(uint64_t sum) {
+    while (sum > 0xffff) {
+        sum = (sum >> 16) + (sum & 0xffff);
+    }
+    return sum;
+}
+
+//! \details The summing kernels below all compute the ones' complement sum of `data`, read as
+//! 16-bit words in host byte order, and may return it unfolded. `len` must be a multiple of 8.
+//!
+//! Because the ones' complement sum is independent of byte order (see [RFC 1071](\ref rfc::rfc1071)),
+//! the words can be added in whatever width and order is fastest and swapped to network order once at the end.
+static uint64_t sum_words_portable(const char *data, const size_t len) {
+    uint64_t sum = 0;
+    for (size_t i = 0; i < len; i += 8) {
+        uint64_t word;
+        memcpy(&word, data + i, sizeof(word));
+        sum = add_with_carry(sum, word);
+    }
+    return sum;
+}
+
+#if defined(__x86_64__)
+//! Number of vector iterations after which the 32-bit lanes (each gaining at most two 16-bit words
+//! per iteration) must be drained before they can overflow
+static constexpr size_t SIMD_BLOCK_ITERATIONS = 0x8000;
+
+//! SSE2 kernel (always available on x86-64)
+static uint64_t sum_words_sse2(const char *data, const size_t len) {
+    const size_t vector_len = len - len % 16;
+    const __m128i zero = _mm_setzero_si128();
+    uint64_t sum = 0;
+    for (size_t i = 0; i < vector_len;) {
+        const size_t block_end = min(vector_len, i + 16 * SIMD_BLOCK_ITERATIONS);
+        __m128i acc = zero;
+        for (; i < block_end; i += 16) {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+            acc = _mm_add_epi32(acc, _mm_unpacklo_epi16(v, zero));
+            acc = _mm_add_epi32(acc, _mm_unpackhi_epi16(v, zero));
+        }
+        alignas(16) array<uint32_t, 4> lanes{};
+        _mm_store_si128(reinterpret_cast<__m128i *>(lanes.data()), acc);
+        for (const auto lane : lanes) {
+            sum += lane;
         }
-        _sum += val;
-        _parity = !_parity;
     }
+    return add_with_carry(sum, sum_words_portable(data + vector_len, len - vector_len));
+}
+
+//! AVX2 kernel (selected at runtime on CPUs that support it)
+__attribute__((target("avx2"))) static uint64_t sum_words_avx2(const char *data, const size_t len) {
+    const size_t vector_len = len - len % 32;
+    const __m256i zero = _mm256_setzero_si256();
+    uint64_t sum = 0;
+    for (size_t i = 0; i < vector_len;) {
+        const size_t block_end = min(vector_len, i + 32 * SIMD_BLOCK_ITERATIONS);
+        __m256i acc = zero;
+        for (; i < block_end; i += 32) {
+            const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+            acc = _mm256_add_epi32(acc, _mm256_unpacklo_epi16(v, zero));
+            acc = _mm256_add_epi32(acc, _mm256_unpackhi_epi16(v, zero));
+        }
+        alignas(32) array<uint32_t, 8> lanes{};
+        _mm256_store_si256(reinterpret_cast<__m256i *>(lanes.data()), acc);
+        for (const auto lane : lanes) {
+            sum += lane;
+        }
+    }
+    return add_with_carry(sum, sum_words_portable(data + vector_len, len - vector_len));
+}
+#endif
+
+using SumWordsT = uint64_t (*)(const char *, const size_t);
+
+//! \returns the summing function for `kernel`, or nullptr if this CPU does not support it
+static SumWordsT sum_words_for(const InternetChecksum::Kernel kernel) {
+    using Kernel = InternetChecksum::Kernel;
+    switch (kernel) {
+        case Kernel::Auto:
+            break;
+        case Kernel::Portable:
+            return sum_words_portable;
+#if defined(__x86_64__)
+        case Kernel::SSE2:
+            return sum_words_sse2;
+        case Kernel::AVX2:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2") ? sum_words_avx2 : nullptr;
+#else
+        case Kernel::SSE2:
+        case Kernel::AVX2:
+            return nullptr;
+#endif
+    }
+
+    // the fastest kernel supported by this CPU
+    for (const Kernel fastest : {Kernel::AVX2, Kernel::SSE2, Kernel::Portable}) {
+        if (const SumWordsT sum_words = sum_words_for(fastest)) {
+            return sum_words;
+        }
+    }
+    return sum_words_portable;
+}
+
+bool InternetChecksum::supported(const Kernel kernel) { return sum_words_for(kernel) != nullptr; }
+
+//! \details `data` may have any length and may follow a previous call that added an odd number
+//! of bytes; the result is the same as adding all of the bytes in a single call.
+void InternetChecksum::add(std::string_view data) {
+    static const SumWordsT fastest = sum_words_for(Kernel::Auto);
+    if (data.empty()) {
+        return;
+    }
+
+    const SumWordsT sum_words = _kernel == Kernel::Auto ? fastest : sum_words_for(_kernel);
+
+    const size_t word_len = data.size() - data.size() % 8;
+    uint64_t sum = sum_words(data.data(), word_len);
+
+    // the last few bytes are padded with zeros, which also handles an odd trailing byte
+    uint64_t tail = 0;
+    memcpy(&tail, data.data() + word_len, data.size() - word_len);
+    sum = add_with_carry(sum, tail);
+
+    // swap to network byte order, and swap again if `data` starts at an odd offset in the checksummed bytes
+    uint16_t net_sum = be16toh(fold_sum(sum));
+    if (_parity) {
+        net_sum = (net_sum >> 8) | (net_sum << 8);
+    }
+
+    _sum = fold_sum(uint64_t(_sum) + net_sum);
+    _parity ^= data.size() % 2;
 }
 
 uint16_t InternetChecksum::value() const {
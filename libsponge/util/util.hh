@@ -51,14 +51,32 @@ std::mt19937 get_random_generator();
 //! Get the time in milliseconds since the program began.
 uint64_t timestamp_ms();
 
+//! Get the time in microseconds since the program began, on the same clock as timestamp_ms().
+uint64_t timestamp_us();
+
 //! The internet checksum algorithm
 class InternetChecksum {
+  public:
+    //! How add() sums the bytes: every kernel gives the same result
+    enum class Kernel {
+        Auto,      //!< The fastest kernel this CPU supports
+        Portable,  //!< 64-bit scalar additions
+        SSE2,      //!< 128-bit vector additions (x86-64 only)
+        AVX2       //!< 256-bit vector additions (x86-64 CPUs with AVX2 only)
+    };
+
+    //! Can `kernel` run on this CPU?
+    static bool supported(const Kernel kernel);
+
   private:
     uint32_t _sum;
     bool _parity{};
+    Kernel _kernel;
 
   public:
-    InternetChecksum(const uint32_t initial_sum = 0);
+    //! \param[in] initial_sum is added to the sum
+    //! \param[in] kernel is how add() sums the bytes (it must be supported)
+    InternetChecksum(const uint32_t initial_sum = 0, const Kernel kernel = Kernel::Auto);
     void add(std::string_view data);
     uint16_t value() const;
 };
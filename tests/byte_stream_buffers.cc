@@ -0,0 +1,150 @@
+#include "buffer.hh"
+#include "byte_stream.hh"
+#include "byte_stream_test_harness.hh"
+#include "tcp_connection.hh"
+#include "test_err_if.hh"
+
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        {
+            ByteStreamTestHarness test{"read_buffer splits a chunk without copying", 15};
+            const Buffer data{string{"hello world"}};
+
+            test.execute(WriteBuffer{data}.with_bytes_written(11));
+            test.execute(ReadBuffer{"hello"}.sharing_storage_with(data.str()));
+            test.execute(BufferSize{6});
+            test.execute(BytesRead{5});
+            test.execute(ReadBuffer{" world"}.sharing_storage_with(data.str()));
+            test.execute(BufferEmpty{true});
+            test.execute(BytesRead{11});
+        }
+
+        {
+            ByteStreamTestHarness test{"read_buffer across chunks", 15};
+
+            test.execute(Write{"ab"});
+            test.execute(WriteMoved{"cd"});
+            test.execute(ReadBuffer{"abc"});
+            test.execute(BufferSize{1});
+            test.execute(ReadBuffer{"d"});
+            test.execute(BufferEmpty{true});
+            test.execute(ReadBuffer{""});
+        }
+
+        {
+            ByteStreamTestHarness test{"peek_buffers across chunk boundaries", 15};
+
+            test.execute(Write{"abc"});
+            test.execute(WriteMoved{"defg"}.with_bytes_written(4));
+            test.execute(WriteBuffer{Buffer{string{"hij"}}}.with_bytes_written(3));
+            test.execute(PeekBuffers{"ab", 1});
+            test.execute(PeekBuffers{"abcde", 2});
+            test.execute(PeekBuffers{"abcdefghij", 3});
+            test.execute(BufferSize{10});
+
+            test.execute(Pop{2});
+            test.execute(PeekBuffers{"cdefgh", 3});
+            test.execute(Pop{2});
+            test.execute(PeekBuffers{"efg", 1});
+            test.execute(PeekBuffers{"efghij", 2});
+            test.execute(Peek{"efghij"});
+            test.execute(BytesRead{4});
+        }
+
+        {
+            ByteStreamTestHarness test{"a Buffer longer than the capacity is trimmed in the stream only", 5};
+            const Buffer data{string{"abcdefgh"}};
+
+            test.execute(WriteBuffer{data}.with_bytes_written(5));
+            test_err_if(data.str() != "abcdefgh", "trimming the stream's copy changed the written Buffer");
+            test.execute(RemainingCapacity{0});
+            test.execute(PeekBuffers{"abcde", 1});
+            test.execute(ReadBuffer{"abcde"}.sharing_storage_with(data.str()));
+            test.execute(WriteBuffer{data}.with_bytes_written(5));
+            test.execute(EndInput{});
+            test.execute(WriteMoved{"x"}.with_bytes_written(0));
+            test.execute(WriteBuffer{data}.with_bytes_written(0));
+            test.execute(BufferSize{5});
+        }
+
+        // a moved-in string keeps its storage only if little of it is spare
+        {
+            ByteStream stream{1000};
+            string roomy;
+            roomy.reserve(64000);
+            roomy.append(100, 'x');
+            stream.write(move(roomy));
+            string tight(100, 'y');
+            const char *const tight_data = tight.data();
+            stream.write(move(tight));
+
+            const Buffer first = stream.read_buffer(100);
+            test_err_if(first.str() != string(100, 'x'), "the roomy string's bytes changed");
+            test_err_if(first.storage_capacity() > 200, "the stream kept a mostly spare allocation");
+            const Buffer second = stream.read_buffer(100);
+            test_err_if(second.str().data() != tight_data, "a tight string was copied");
+        }
+
+        // so does TCPConnection::write, which TCPSpongeSocket hands each read from the owner's pipe
+        {
+            TCPConnection conn{TCPConfig{}};
+            conn.connect();
+            TCPSegment syn_ack;
+            syn_ack.header().syn = syn_ack.header().ack = true;
+            syn_ack.header().ackno = conn.segments_out().front().header().seqno + 1;
+            syn_ack.header().win = 1000;
+            conn.segments_out().pop();
+            conn.segment_received(syn_ack);
+            while (not conn.segments_out().empty()) {
+                conn.segments_out().pop();
+            }
+
+            string roomy;
+            roomy.reserve(64000);
+            roomy.append(100, 'x');
+            test_err_if(conn.write(move(roomy)) != 100, "TCPConnection didn't accept the write");
+            test_err_if(conn.segments_out().empty(), "TCPConnection didn't send the write");
+            const Buffer &payload = conn.segments_out().front().payload();
+            test_err_if(payload.str() != string(100, 'x'), "the segment's payload is wrong");
+            test_err_if(payload.storage_capacity() > 200, "the segment kept a mostly spare allocation");
+        }
+
+        // remove_suffix trims one copy of a Buffer and leaves the others alone
+        {
+            const Buffer original{string{"hello world"}};
+            Buffer copy = original;
+            copy.remove_suffix(6);
+            test_err_if(copy.str() != "hello", "remove_suffix kept the wrong bytes");
+            test_err_if(original.str() != "hello world", "remove_suffix changed another copy of the Buffer");
+            test_err_if(copy.str().data() != original.str().data(), "remove_suffix copied the bytes");
+
+            copy.remove_prefix(1);
+            copy.remove_suffix(1);
+            test_err_if(copy.str() != "ell", "remove_prefix and remove_suffix together kept the wrong bytes");
+
+            bool threw = false;
+            try {
+                copy.remove_suffix(4);
+            } catch (const out_of_range &) {
+                threw = true;
+            }
+            test_err_if(not threw, "remove_suffix past the front did not throw");
+
+            copy.remove_suffix(3);
+            test_err_if(copy.size() != 0, "remove_suffix of every byte left some");
+            test_err_if(original.str() != "hello world", "emptying one copy changed another");
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
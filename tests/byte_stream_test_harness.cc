@@ -97,11 +97,59 @@ void Write::execute(ByteStream &bs) const {
     }
 }
 
+// WriteMoved
+std::string WriteMoved::description() const { return "write \"" + _data + "\" to the stream by move"; }
+void WriteMoved::execute(ByteStream &bs) const {
+    auto bytes_written = bs.write(std::string(_data));
+    if (_bytes_written and bytes_written != _bytes_written.value()) {
+        throw ByteStreamExpectationViolation::property("bytes_written", _bytes_written.value(), bytes_written);
+    }
+}
+
+// WriteBuffer
+WriteBuffer::WriteBuffer(const Buffer &data) : _data(data) {}
+WriteBuffer &WriteBuffer::with_bytes_written(const size_t bytes_written) {
+    _bytes_written = bytes_written;
+    return *this;
+}
+std::string WriteBuffer::description() const { return "write Buffer \"" + _data.copy() + "\" to the stream"; }
+void WriteBuffer::execute(ByteStream &bs) const {
+    auto bytes_written = bs.write(_data);
+    if (_bytes_written and bytes_written != _bytes_written.value()) {
+        throw ByteStreamExpectationViolation::property("bytes_written", _bytes_written.value(), bytes_written);
+    }
+}
+
 // Pop
 Pop::Pop(const size_t len) : _len(len) {}
 std::string Pop::description() const { return "pop " + to_string(_len); }
 void Pop::execute(ByteStream &bs) const { bs.pop_output(_len); }
 
+// ReadBuffer
+ReadBuffer::ReadBuffer(const std::string &output) : _output(output) {}
+ReadBuffer &ReadBuffer::sharing_storage_with(const std::string_view storage) {
+    _shared_with = storage;
+    return *this;
+}
+std::string ReadBuffer::description() const {
+    return "read_buffer(" + to_string(_output.size()) + ") returns \"" + _output + "\"" +
+           (_shared_with ? " without copying" : "");
+}
+void ReadBuffer::execute(ByteStream &bs) const {
+    const Buffer output = bs.read_buffer(_output.size());
+    if (output.str() != _output) {
+        throw ByteStreamExpectationViolation("Expected read_buffer() to return \"" + _output +
+                                             "\", but it returned \"" + output.copy() + "\"");
+    }
+    if (_shared_with) {
+        const char *begin = _shared_with->data();
+        const char *data = output.str().data();
+        if (data < begin or data + output.size() > begin + _shared_with->size()) {
+            throw ByteStreamExpectationViolation("Expected read_buffer() to share storage with the written Buffer");
+        }
+    }
+}
+
 // InputEnded
 InputEnded::InputEnded(const bool input_ended) : _input_ended(input_ended) {}
 std::string InputEnded::description() const { return "input_ended: " + to_string(_input_ended); }
@@ -172,6 +220,25 @@ void BytesRead::execute(ByteStream &bs) const {
     }
 }
 
+// PeekBuffers
+PeekBuffers::PeekBuffers(const std::string &output, const size_t buffer_count)
+    : _output(output), _buffer_count(buffer_count) {}
+std::string PeekBuffers::description() const {
+    return "\"" + _output + "\" at the front of the stream, in " + to_string(_buffer_count) + " Buffers";
+}
+void PeekBuffers::execute(ByteStream &bs) const {
+    const BufferList output = bs.peek_buffers(_output.size());
+    const std::string concatenated = output.concatenate();
+    if (concatenated != _output) {
+        throw ByteStreamExpectationViolation("Expected \"" + _output + "\" from peek_buffers(), but found \"" +
+                                             concatenated + "\"");
+    }
+    if (output.buffers().size() != _buffer_count) {
+        throw ByteStreamExpectationViolation::property("peek_buffers().buffers().size()", _buffer_count,
+                                                       output.buffers().size());
+    }
+}
+
 // Peek
 Peek::Peek(const std::string &output) : _output(output) {}
 std::string Peek::description() const { return "\"" + _output + "\" at the front of the stream"; }
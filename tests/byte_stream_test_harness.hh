@@ -10,6 +10,7 @@
 #include <memory>
 #include <optional>
 #include <string>
+#include <string_view>
 
 struct ByteStreamTestStep {
     virtual operator std::string() const;
@@ -56,6 +57,23 @@ struct Write : public ByteStreamAction {
     void execute(ByteStream &) const override;
 };
 
+//! Write through the overload that takes ownership of a std::string
+struct WriteMoved : public Write {
+    using Write::Write;
+    std::string description() const override;
+    void execute(ByteStream &) const override;
+};
+
+struct WriteBuffer : public ByteStreamAction {
+    Buffer _data;
+    std::optional<size_t> _bytes_written{};
+
+    WriteBuffer(const Buffer &data);
+    WriteBuffer &with_bytes_written(const size_t bytes_written);
+    std::string description() const override;
+    void execute(ByteStream &) const override;
+};
+
 struct Pop : public ByteStreamAction {
     size_t _len;
 
@@ -64,6 +82,17 @@ struct Pop : public ByteStreamAction {
     void execute(ByteStream &) const override;
 };
 
+//! Pop bytes with read_buffer(), and check them (and, optionally, that they were not copied)
+struct ReadBuffer : public ByteStreamAction {
+    std::string _output;
+    std::optional<std::string_view> _shared_with{};
+
+    ReadBuffer(const std::string &output);
+    ReadBuffer &sharing_storage_with(const std::string_view storage);
+    std::string description() const override;
+    void execute(ByteStream &) const override;
+};
+
 struct InputEnded : public ByteStreamExpectation {
     bool _input_ended;
 
@@ -128,6 +157,16 @@ struct Peek : public ByteStreamExpectation {
     void execute(ByteStream &) const override;
 };
 
+//! Check the bytes that peek_buffers() returns, and how many Buffers hold them
+struct PeekBuffers : public ByteStreamExpectation {
+    std::string _output;
+    size_t _buffer_count;
+
+    PeekBuffers(const std::string &output, const size_t buffer_count);
+    std::string description() const override;
+    void execute(ByteStream &) const override;
+};
+
 class ByteStreamTestHarness {
     std::string _test_name;
     ByteStream _byte_stream;
@@ -0,0 +1,143 @@
+#include "eventloop.hh"
+#include "file_descriptor.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+//! A connected pair of Unix-domain stream sockets
+static pair<FileDescriptor, FileDescriptor> socket_pair() {
+    int fds[2];
+    SystemCall("socketpair", ::socketpair(AF_UNIX, SOCK_STREAM, 0, static_cast<int *>(fds)));
+    return {FileDescriptor(fds[0]), FileDescriptor(fds[1])};
+}
+
+static void test_backend(const EventLoop::Backend backend, const string &name) {
+    const bool epoll = backend == EventLoop::Backend::Epoll;
+
+    // a ready fd runs its callback, and an idle loop times out
+    {
+        EventLoop loop{backend};
+        auto [a, b] = socket_pair();
+        string received;
+        loop.add_rule(b, Direction::In, [&] { received += b.read(); });
+
+        test_err_if(loop.wait_next_event(0) != EventLoop::Result::Timeout, name + ": idle loop should time out");
+        a.write("hello");
+        test_err_if(loop.wait_next_event(0) != EventLoop::Result::Success, name + ": ready fd not reported");
+        test_err_if(received != "hello", name + ": callback did not run");
+        test_err_if(loop.wait_next_event(0) != EventLoop::Result::Timeout, name + ": drained fd still reported");
+    }
+
+    // rules for both directions of one fd, and interest that changes
+    {
+        EventLoop loop{backend};
+        auto [a, b] = socket_pair();
+        string received;
+        string to_send;
+        loop.add_rule(b, Direction::In, [&] { received += b.read(); });
+        const auto out = loop.add_rule(
+            b,
+            Direction::Out,
+            [&] {
+                b.write(to_send);
+                to_send.clear();
+            },
+            [&] { return not to_send.empty(); });
+
+        test_err_if(loop.wait_next_event(0) != EventLoop::Result::Timeout, name + ": uninterested rule ran");
+        to_send = "ping";
+        loop.wait_next_event(0);
+        test_err_if(epoll != (to_send == "ping"), name + ": interest re-evaluated at the wrong time");
+        loop.interest_changed(out);
+        loop.wait_next_event(0);
+        test_err_if(not to_send.empty() or a.read() != "ping", name + ": write rule did not run");
+
+        a.write("pong");
+        loop.wait_next_event(0);
+        test_err_if(received != "pong", name + ": read rule on the same fd did not run");
+    }
+
+    // EOF cancels the rule, and a loop with no rules left exits
+    {
+        EventLoop loop{backend};
+        auto [a, b] = socket_pair();
+        bool canceled = false;
+        loop.add_rule(b, Direction::In, [&] { b.read(); }, [] { return true; }, [&] { canceled = true; });
+
+        a.close();
+        test_err_if(loop.wait_next_event(0) != EventLoop::Result::Success, name + ": EOF not reported");
+        test_err_if(loop.wait_next_event(0) != EventLoop::Result::Exit, name + ": loop should exit");
+        test_err_if(not canceled, name + ": cancel callback not called");
+    }
+
+    // a hangup cancels a write rule even while it is uninterested, so that it cannot end every wait
+    {
+        EventLoop loop{backend};
+        auto [a, b] = socket_pair();
+        auto [c, d] = socket_pair();
+        bool canceled = false;
+        loop.add_rule(b, Direction::Out, [&] { b.write("x"); }, [] { return false; }, [&] { canceled = true; });
+        loop.add_rule(d, Direction::In, [&] { d.read(); });
+
+        a.close();
+        loop.wait_next_event(0);
+        test_err_if(not canceled, name + ": hung-up write rule not canceled");
+        test_err_if(loop.wait_next_event(0) != EventLoop::Result::Timeout, name + ": hangup still reported");
+    }
+
+    // only the ready fd's callback runs, however many are registered
+    {
+        EventLoop loop{backend};
+        vector<pair<FileDescriptor, FileDescriptor>> pairs;
+        vector<unsigned> calls(200);
+        for (size_t i = 0; i < calls.size(); i++) {
+            pairs.push_back(socket_pair());
+            loop.add_rule(pairs.back().second, Direction::In, [&, i] {
+                pairs[i].second.read();
+                calls[i]++;
+            });
+        }
+
+        pairs[123].first.write("x");
+        test_err_if(loop.wait_next_event(0) != EventLoop::Result::Success, name + ": ready fd not reported");
+        for (size_t i = 0; i < calls.size(); i++) {
+            test_err_if(calls[i] != (i == 123), name + ": wrong callback ran");
+        }
+    }
+}
+
+int main() {
+    try {
+        test_backend(EventLoop::Backend::Poll, "poll");
+        test_backend(EventLoop::Backend::Epoll, "epoll");
+
+        // epoll registers each fd once, so one rule per direction
+        {
+            EventLoop loop{EventLoop::Backend::Epoll};
+            auto [a, b] = socket_pair();
+            loop.add_rule(b, Direction::In, [&] { b.read(); });
+            bool threw = false;
+            try {
+                loop.add_rule(b, Direction::In, [&] { b.read(); });
+            } catch (const runtime_error &) {
+                threw = true;
+            }
+            test_err_if(not threw, "epoll: a second rule for the same fd and direction should be refused");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
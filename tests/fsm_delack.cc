@@ -0,0 +1,133 @@
+#include "tcp_config.hh"
+#include "tcp_expectation.hh"
+#include "tcp_fsm_test_harness.hh"
+#include "tcp_segment.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+using State = TCPTestHarness::State;
+
+//! A 100-byte data segment at `offset` bytes into the peer's stream
+static SendSegment data_at(const WrappingInt32 rx_isn, const WrappingInt32 tx_isn, const uint32_t offset) {
+    return SendSegment{}
+        .with_ack(true)
+        .with_seqno(rx_isn + 1 + offset)
+        .with_ackno(tx_isn + 1)
+        .with_win(1000)
+        .with_data(string(100, 'x'));
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        TCPConfig cfg{};
+        cfg.delack_segments = 2;
+        cfg.delack_timeout = 40;
+
+        // test 1: every second in-order segment is acknowledged, and a lone one after the timeout
+        {
+            const WrappingInt32 tx_isn(rd()), rx_isn(rd());
+            TCPTestHarness test_1 = TCPTestHarness::in_established(cfg, tx_isn, rx_isn);
+
+            test_1.execute(data_at(rx_isn, tx_isn, 0));
+            test_1.execute(ExpectNoSegment{}, "test 1 failed: first segment acknowledged at once");
+            test_1.execute(data_at(rx_isn, tx_isn, 100));
+            test_1.execute(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 201),
+                           "test 1 failed: second segment should be acknowledged");
+
+            test_1.execute(data_at(rx_isn, tx_isn, 200));
+            test_1.execute(Tick(39));
+            test_1.execute(ExpectNoSegment{}, "test 1 failed: delayed ACK sent early");
+            test_1.execute(Tick(1));
+            test_1.execute(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 301),
+                           "test 1 failed: delayed ACK not sent after the timeout");
+            test_1.execute(Tick(100));
+            test_1.execute(ExpectNoSegment{}, "test 1 failed: delayed ACK sent twice");
+        }
+
+        // test 2: out-of-order, gap-filling, duplicate, PSH and FIN segments are acknowledged at once
+        {
+            const WrappingInt32 tx_isn(rd()), rx_isn(rd());
+            TCPTestHarness test_2 = TCPTestHarness::in_established(cfg, tx_isn, rx_isn);
+
+            test_2.execute(data_at(rx_isn, tx_isn, 100));
+            test_2.execute(ExpectOneSegment{}.with_ackno(rx_isn + 1), "test 2 failed: out-of-order segment");
+            test_2.execute(data_at(rx_isn, tx_isn, 0));
+            test_2.execute(ExpectOneSegment{}.with_ackno(rx_isn + 201), "test 2 failed: gap-filling segment");
+            test_2.execute(data_at(rx_isn, tx_isn, 0));
+            test_2.execute(ExpectOneSegment{}.with_ackno(rx_isn + 201), "test 2 failed: duplicate segment");
+            test_2.execute(data_at(rx_isn, tx_isn, 200).with_psh(true));
+            test_2.execute(ExpectOneSegment{}.with_ackno(rx_isn + 301), "test 2 failed: PSH segment");
+
+            test_2.execute(data_at(rx_isn, tx_isn, 300));
+            test_2.execute(ExpectNoSegment{});
+            test_2.execute(SendSegment{}.with_ack(true).with_fin(true).with_seqno(rx_isn + 401).with_ackno(tx_isn + 1));
+            test_2.execute(ExpectOneSegment{}.with_ackno(rx_isn + 402), "test 2 failed: FIN");
+            test_2.execute(ExpectState{State::CLOSE_WAIT});
+        }
+
+        // test 3: data we send carries the acknowledgment, which is then no longer pending
+        {
+            const WrappingInt32 tx_isn(rd()), rx_isn(rd());
+            TCPTestHarness test_3 = TCPTestHarness::in_established(cfg, tx_isn, rx_isn);
+
+            test_3.execute(data_at(rx_isn, tx_isn, 0));
+            test_3.execute(ExpectNoSegment{});
+            test_3.execute(Write{"hello"});
+            test_3.execute(ExpectOneSegment{}.with_data("hello").with_ackno(rx_isn + 101),
+                           "test 3 failed: data should carry the pending ACK");
+            test_3.execute(Tick(40));
+            test_3.execute(ExpectNoSegment{}, "test 3 failed: ACK sent again after piggybacking");
+        }
+
+        // test 4: stretch ACKs
+        {
+            TCPConfig stretch = cfg;
+            stretch.delack_segments = 4;
+            const WrappingInt32 tx_isn(rd()), rx_isn(rd());
+            TCPTestHarness test_4 = TCPTestHarness::in_established(stretch, tx_isn, rx_isn);
+
+            for (uint32_t i = 0; i < 3; i++) {
+                test_4.execute(data_at(rx_isn, tx_isn, 100 * i));
+                test_4.execute(ExpectNoSegment{}, "test 4 failed: ACK sent before the fourth segment");
+            }
+            test_4.execute(data_at(rx_isn, tx_isn, 300));
+            test_4.execute(ExpectOneSegment{}.with_ackno(rx_isn + 401), "test 4 failed: fourth segment");
+        }
+
+        // test 5: a run of coalesced segments is acknowledged like one segment
+        {
+            const WrappingInt32 tx_isn(rd()), rx_isn(rd());
+            TCPTestHarness test_5 = TCPTestHarness::in_established(cfg, tx_isn, rx_isn);
+
+            test_5.execute(SendRun{{data_at(rx_isn, tx_isn, 0), data_at(rx_isn, tx_isn, 100)}});
+            test_5.execute(ExpectNoSegment{}, "test 5 failed: a run should count as one segment");
+            test_5.execute(ExpectData{}.with_data(string(200, 'x')), "test 5 failed: data from a run was lost");
+            test_5.execute(SendRun{{data_at(rx_isn, tx_isn, 200), data_at(rx_isn, tx_isn, 300)}});
+            test_5.execute(ExpectOneSegment{}.with_ackno(rx_isn + 401), "test 5 failed: second run");
+
+            test_5.execute(
+                SendRun{{data_at(rx_isn, tx_isn, 400), data_at(rx_isn, tx_isn, 500), data_at(rx_isn, tx_isn, 600)}});
+            test_5.execute(Tick(40));
+            test_5.execute(ExpectOneSegment{}.with_ackno(rx_isn + 701), "test 5 failed: delayed ACK of a run");
+
+            test_5.execute(SendRun{{data_at(rx_isn, tx_isn, 700), data_at(rx_isn, tx_isn, 800).with_psh(true)}});
+            test_5.execute(ExpectOneSegment{}.with_ackno(rx_isn + 901), "test 5 failed: PSH on a run's last segment");
+
+            test_5.execute(SendRun{{data_at(rx_isn, tx_isn, 1000), data_at(rx_isn, tx_isn, 1100)}});
+            test_5.execute(ExpectOneSegment{}.with_ackno(rx_isn + 901), "test 5 failed: out-of-order run");
+            test_5.execute(ExpectUnassembledBytes{200});
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,178 @@
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+#include "tcp_expectation.hh"
+#include "tcp_fsm_test_harness.hh"
+#include "tcp_header.hh"
+#include "tcp_segment.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+using State = TCPTestHarness::State;
+
+//! Drain the connection's outbound queue
+static vector<TCPSegment> take_segments(TCPConnection &conn) {
+    vector<TCPSegment> ret;
+    while (not conn.segments_out().empty()) {
+        ret.push_back(conn.segments_out().front());
+        conn.segments_out().pop();
+    }
+    return ret;
+}
+
+//! Complete an active open of `conn` with a SYN/ACK announcing `peer_mss`
+static WrappingInt32 handshake(TCPConnection &conn, const optional<uint16_t> peer_mss) {
+    conn.connect();
+    const vector<TCPSegment> syn = take_segments(conn);
+    test_err_if(syn.size() != 1 or not syn[0].header().syn, "expected a SYN");
+
+    TCPSegment syn_ack;
+    syn_ack.header().syn = true;
+    syn_ack.header().ack = true;
+    syn_ack.header().seqno = WrappingInt32{0};
+    syn_ack.header().ackno = syn[0].header().seqno + 1;
+    syn_ack.header().win = 60000;
+    syn_ack.header().mss = peer_mss;
+    conn.segment_received(syn_ack);
+    take_segments(conn);
+    return syn[0].header().seqno;
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        // test 1: a smaller MSS from the peer is obeyed, even if we announce none
+        {
+            TCPConfig cfg{};
+            TCPTestHarness test_1 = TCPTestHarness::in_listen(cfg);
+            const WrappingInt32 rx_isn(rd());
+            test_1.execute(SendSegment{}.with_syn(true).with_seqno(rx_isn).with_win(5000).with_mss(400));
+            TCPSegment syn_ack = test_1.expect_seg(ExpectOneSegment{}.with_syn(true).with_ack(true),
+                                                   "test 1 failed: no SYN/ACK");
+            test_err_if(syn_ack.header().mss.has_value(), "test 1 failed: MSS announced without being configured");
+
+            test_1.send_ack(rx_isn + 1, syn_ack.header().seqno + 1, 5000);
+            test_1.execute(ExpectState{State::ESTABLISHED});
+            test_1.execute(Write{string(1000, 'x')});
+            test_1.execute(ExpectSegment{}.with_payload_size(400), "test 1 failed: peer's MSS not obeyed");
+            test_1.execute(ExpectSegment{}.with_payload_size(400));
+            test_1.execute(ExpectSegment{}.with_payload_size(200));
+            test_1.execute(ExpectNoSegment{});
+        }
+
+        // test 2: the configured MSS is announced, and caps segments even if the peer announces none
+        {
+            TCPConfig cfg{};
+            cfg.mss = 600;
+            TCPTestHarness test_2(cfg);
+            test_2.execute(Connect{});
+            TCPSegment syn = test_2.expect_seg(ExpectOneSegment{}.with_syn(true), "test 2 failed: no SYN");
+            test_err_if(syn.header().mss != 600, "test 2 failed: SYN should announce the configured MSS");
+
+            const WrappingInt32 rx_isn(rd());
+            test_2.execute(SendSegment{}
+                               .with_syn(true)
+                               .with_ack(true)
+                               .with_seqno(rx_isn)
+                               .with_ackno(syn.header().seqno + 1)
+                               .with_win(5000));
+            test_2.execute(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 1));
+            test_2.execute(Write{string(1000, 'x')});
+            test_2.execute(ExpectSegment{}.with_payload_size(600), "test 2 failed: configured MSS not obeyed");
+            test_2.execute(ExpectSegment{}.with_payload_size(400));
+        }
+
+        // test 3: segments grow past MAX_PAYLOAD_SIZE only when both sides announce a larger MSS
+        {
+            TCPConfig cfg{};
+            cfg.mss = 1460;
+            TCPConnection conn{cfg};
+            handshake(conn, 1460);
+            test_err_if(conn.mss() != 1460, "test 3 failed: MSS not negotiated");
+            conn.write(string(3000, 'x'));
+            const vector<TCPSegment> segs = take_segments(conn);
+            test_err_if(segs.size() != 3 or segs[0].payload().size() != 1460 or segs[2].payload().size() != 80,
+                        "test 3 failed: data not sent in 1460-byte segments");
+
+            TCPConnection plain{TCPConfig{}};
+            handshake(plain, 1460);
+            test_err_if(plain.mss() != TCPConfig::MAX_PAYLOAD_SIZE,
+                        "test 3 failed: MSS grew without being configured");
+        }
+
+        // test 4: with GSO, the sender builds segments of several MSS, which split into wire segments
+        {
+            TCPConfig cfg{};
+            cfg.gso_segments = 4;
+            TCPConnection conn{cfg};
+            const WrappingInt32 tx_isn = handshake(conn, {});
+            conn.write(string(10000, 'x'));
+            const vector<TCPSegment> segs = take_segments(conn);
+            test_err_if(segs.size() != 3 or segs[0].payload().size() != 4000 or segs[2].payload().size() != 2000,
+                        "test 4 failed: sender should build segments of up to four MSS");
+            test_err_if(conn.bytes_in_flight() != 10000, "test 4 failed: wrong bytes in flight");
+
+            const vector<TCPSegment> wire = segs[1].split(conn.mss());
+            test_err_if(wire.size() != 4, "test 4 failed: segment should split into four wire segments");
+            for (size_t i = 0; i < wire.size(); i++) {
+                test_err_if(wire[i].payload().size() != TCPConfig::MAX_PAYLOAD_SIZE or
+                                wire[i].header().seqno != tx_isn + 1 + 4000 + 1000 * i,
+                            "test 4 failed: wire segment " + to_string(i) + " is wrong");
+            }
+        }
+
+        // test 5: with GSO, a retransmission carries one MSS, which needs no further split
+        {
+            TCPConfig cfg{};
+            cfg.gso_segments = 4;
+            TCPConnection conn{cfg};
+            const WrappingInt32 tx_isn = handshake(conn, {});
+            string data(4000, 'x');
+            for (size_t i = 0; i < data.size(); i++) {
+                data[i] = static_cast<char>(rd());
+            }
+            conn.write(data);
+            const vector<TCPSegment> segs = take_segments(conn);
+            test_err_if(segs.size() != 1 or segs[0].payload().size() != 4000,
+                        "test 5 failed: sender should build one segment of four MSS");
+            const vector<TCPSegment> wire = segs[0].split(conn.mss());
+
+            conn.tick(cfg.rt_timeout);
+            vector<TCPSegment> retx = take_segments(conn);
+            test_err_if(retx.size() != 1 or retx[0].header().seqno != tx_isn + 1 or
+                            retx[0].payload().str() != data.substr(0, 1000),
+                        "test 5 failed: the timeout should retransmit the first MSS");
+            test_err_if(retx[0].serialize().concatenate() != wire[0].serialize().concatenate(),
+                        "test 5 failed: the retransmission differs from the first wire segment");
+            test_err_if(conn.bytes_in_flight() != 4000, "test 5 failed: wrong bytes in flight");
+
+            // an ACK of two wire segments leaves the other two outstanding
+            TCPSegment ack;
+            ack.header().ack = true;
+            ack.header().seqno = WrappingInt32{1};
+            ack.header().ackno = tx_isn + 1 + 2000;
+            ack.header().win = 60000;
+            conn.segment_received(ack);
+            take_segments(conn);
+            test_err_if(conn.bytes_in_flight() != 2000, "test 5 failed: wrong bytes in flight after the ACK");
+
+            conn.tick(2 * cfg.rt_timeout);
+            retx = take_segments(conn);
+            test_err_if(retx.size() != 1 or retx[0].serialize().concatenate() != wire[2].serialize().concatenate(),
+                        "test 5 failed: the timeout should retransmit the third wire segment");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return err_num;
+    }
+
+    return EXIT_SUCCESS;
+}
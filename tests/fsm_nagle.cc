@@ -0,0 +1,89 @@
+#include "tcp_config.hh"
+#include "tcp_expectation.hh"
+#include "tcp_fsm_test_harness.hh"
+#include "tcp_segment.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+using State = TCPTestHarness::State;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        // test 1: with Nagle's algorithm, small writes wait for the data in flight to be acknowledged
+        {
+            TCPConfig cfg{};
+            cfg.nagle = true;
+            const WrappingInt32 tx_isn(rd()), rx_isn(rd());
+            TCPTestHarness test_1 = TCPTestHarness::in_established(cfg, tx_isn, rx_isn);
+            test_1.send_ack(rx_isn + 1, tx_isn + 1, 10000);
+
+            test_1.execute(Write{"a"});
+            test_1.execute(ExpectOneSegment{}.with_data("a"), "test 1 failed: nothing in flight, so send at once");
+            test_1.execute(Write{"b"});
+            test_1.execute(Write{"c"});
+            test_1.execute(ExpectNoSegment{}, "test 1 failed: small segment sent while data in flight");
+
+            test_1.send_ack(rx_isn + 1, tx_isn + 2, 10000);
+            test_1.execute(ExpectOneSegment{}.with_data("bc"), "test 1 failed: held data not sent on the ACK");
+
+            // a full segment goes out regardless, and the rest waits
+            test_1.execute(Write{string(1200, 'x')});
+            test_1.execute(ExpectOneSegment{}.with_payload_size(1000), "test 1 failed: full segment held back");
+            test_1.execute(ExpectBytesInFlight{1002});
+
+            test_1.execute(Flush{});
+            test_1.execute(ExpectOneSegment{}.with_payload_size(200), "test 1 failed: flush did not send");
+
+            // the last data goes out with the FIN
+            test_1.execute(Write{"d"});
+            test_1.execute(ExpectNoSegment{});
+            test_1.execute(Close{});
+            test_1.execute(ExpectOneSegment{}.with_data("d").with_fin(true), "test 1 failed: FIN held back");
+        }
+
+        // test 2: without Nagle's algorithm, every write is sent at once
+        {
+            const WrappingInt32 tx_isn(rd()), rx_isn(rd());
+            TCPTestHarness test_2 = TCPTestHarness::in_established(TCPConfig{}, tx_isn, rx_isn);
+            test_2.send_ack(rx_isn + 1, tx_isn + 1, 10000);
+
+            test_2.execute(Write{"a"});
+            test_2.execute(ExpectOneSegment{}.with_data("a"));
+            test_2.execute(Write{"b"});
+            test_2.execute(ExpectOneSegment{}.with_data("b"), "test 2 failed: small segment held back");
+        }
+
+        // test 3: a cork holds back everything short of a full segment, even with nothing in flight
+        {
+            const WrappingInt32 tx_isn(rd()), rx_isn(rd());
+            TCPTestHarness test_3 = TCPTestHarness::in_established(TCPConfig{}, tx_isn, rx_isn);
+            test_3.send_ack(rx_isn + 1, tx_isn + 1, 10000);
+
+            test_3.execute(Cork{});
+            test_3.execute(Write{"hello"});
+            test_3.execute(ExpectNoSegment{}, "test 3 failed: corked data sent");
+            test_3.execute(Write{string(1500, 'x')});
+            test_3.execute(ExpectOneSegment{}.with_payload_size(1000), "test 3 failed: full segment held back");
+            test_3.execute(Tick(500));
+            test_3.execute(ExpectNoSegment{}, "test 3 failed: corked data sent");
+
+            test_3.execute(Uncork{});
+            test_3.execute(ExpectOneSegment{}.with_payload_size(505), "test 3 failed: uncork did not send");
+            test_3.execute(Write{"a"});
+            test_3.execute(ExpectOneSegment{}.with_data("a"), "test 3 failed: still corked");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,132 @@
+#include "buffer.hh"
+#include "byte_stream.hh"
+#include "fsm_stream_reassembler_harness.hh"
+#include "stream_reassembler.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        // a Buffer that covers stored substrings on both sides replaces them
+        {
+            ReassemblerTestHarness test{65000};
+
+            test.execute(SubmitSegment{"c", 2});
+            test.execute(SubmitSegment{"g", 6});
+            test.execute(UnassembledBytes(2));
+
+            test.execute(SubmitBuffer{Buffer{string{"bcdefgh"}}, 1});
+            test.execute(BytesAssembled(0));
+            test.execute(UnassembledBytes(7));
+
+            test.execute(SubmitBuffer{Buffer{string{"a"}}, 0});
+            test.execute(BytesAssembled(8));
+            test.execute(UnassembledBytes(0));
+            test.execute(BytesAvailable("abcdefgh"));
+            test.execute(NotAtEof{});
+        }
+
+        // a Buffer that partially overlaps stored substrings on both sides is trimmed to the gap between them
+        {
+            ReassemblerTestHarness test{65000};
+
+            test.execute(SubmitSegment{"cde", 2});
+            test.execute(SubmitSegment{"ghi", 6});
+            test.execute(UnassembledBytes(6));
+
+            test.execute(SubmitBuffer{Buffer{string{"defgh"}}, 3});
+            test.execute(BytesAssembled(0));
+            test.execute(UnassembledBytes(7));
+
+            test.execute(SubmitBuffer{Buffer{string{"ab"}}, 0});
+            test.execute(BytesAssembled(9));
+            test.execute(UnassembledBytes(0));
+            test.execute(BytesAvailable("abcdefghi"));
+
+            test.execute(SubmitBuffer{Buffer{string{"j"}}, 9}.with_eof(true));
+            test.execute(BytesAvailable("j"));
+            test.execute(AtEof{});
+        }
+
+        // a Buffer that continues the stream but overlaps a stored substring merges with it
+        {
+            ReassemblerTestHarness test{65000};
+
+            test.execute(SubmitSegment{"def", 3});
+            test.execute(SubmitBuffer{Buffer{string{"abcdefgh"}}, 0}.with_eof(true));
+            test.execute(BytesAssembled(8));
+            test.execute(UnassembledBytes(0));
+            test.execute(BytesAvailable("abcdefgh"));
+            test.execute(AtEof{});
+        }
+
+        // a Buffer that starts inside the assembled bytes only contributes the new ones
+        {
+            ReassemblerTestHarness test{65000};
+
+            test.execute(SubmitBuffer{Buffer{string{"abcd"}}, 0});
+            test.execute(SubmitBuffer{Buffer{string{"cdef"}}, 2});
+            test.execute(BytesAssembled(6));
+            test.execute(BytesAvailable("abcdef"));
+        }
+
+        // a Buffer trimmed from both ends submits only the bytes it still views
+        {
+            ReassemblerTestHarness test{65000};
+
+            Buffer view{string{"xxabcdyy"}};
+            view.remove_prefix(2);
+            view.remove_suffix(2);
+
+            test.execute(SubmitSegment{"ef", 4});
+            test.execute(SubmitBuffer{view, 0});
+            test.execute(BytesAssembled(6));
+            test.execute(BytesAvailable("abcdef"));
+        }
+
+        // a Buffer that runs past the window is cut at the capacity, and its EOF is dropped
+        {
+            ReassemblerTestHarness test{8};
+
+            test.execute(SubmitSegment{"b", 1});
+            test.execute(SubmitBuffer{Buffer{string{"abcdefghijkl"}}, 0}.with_eof(true));
+            test.execute(BytesAssembled(8));
+            test.execute(UnassembledBytes(0));
+            test.execute(BytesAvailable("abcdefgh"));
+            test.execute(NotAtEof{});
+
+            test.execute(SubmitBuffer{Buffer{string{"ijkl"}}, 8}.with_eof(true));
+            test.execute(BytesAvailable("ijkl"));
+            test.execute(AtEof{});
+        }
+
+        // pushing a Buffer leaves the caller's copy unchanged, and the stream shares its storage
+        {
+            StreamReassembler reassembler{65000};
+            const Buffer stored{string{"cdefgh"}};
+            const Buffer data{string{"abcdefghij"}};
+
+            reassembler.push_substring(stored, 2, false);
+            reassembler.push_substring(data, 0, false);
+            test_err_if(stored.str() != "cdefgh", "pushing a Buffer changed the caller's copy");
+            test_err_if(data.str() != "abcdefghij", "pushing a Buffer changed the caller's copy");
+            test_err_if(reassembler.stream_out().buffer_size() != 10, "the reassembler lost bytes");
+
+            const Buffer head = reassembler.stream_out().read_buffer(2);
+            test_err_if(head.str() != "ab", "the reassembler reordered bytes");
+            test_err_if(head.str().data() != data.str().data(), "the reassembler copied the pushed Buffer");
+            test_err_if(reassembler.stream_out().read(8) != "cdefghij", "the reassembler reordered bytes");
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,115 @@
+#include "buffer.hh"
+#include "byte_stream.hh"
+#include "fsm_stream_reassembler_harness.hh"
+#include "stream_reassembler.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        // in-order substrings that stop short of a stored one are assembled, and leave it stored
+        {
+            ReassemblerTestHarness test{65000};
+
+            test.execute(SubmitSegment{"ghi", 6});
+            test.execute(SubmitSegment{"ab", 0});
+            test.execute(BytesAssembled(2));
+            test.execute(UnassembledBytes(3));
+
+            test.execute(SubmitSegment{"cd", 2});
+            test.execute(BytesAssembled(4));
+            test.execute(UnassembledBytes(3));
+            test.execute(BytesAvailable("abcd"));
+
+            // one that ends where the stored substring starts pulls it into the stream
+            test.execute(SubmitSegment{"ef", 4});
+            test.execute(BytesAssembled(9));
+            test.execute(UnassembledBytes(0));
+            test.execute(BytesAvailable("efghi"));
+        }
+
+        // an in-order substring that reaches past several stored ones only contributes bytes once
+        {
+            ReassemblerTestHarness test{65000};
+
+            test.execute(SubmitSegment{"cd", 2});
+            test.execute(SubmitSegment{"gh", 6});
+            test.execute(SubmitSegment{"l", 11});
+            test.execute(UnassembledBytes(5));
+
+            test.execute(SubmitSegment{"abcdefghi", 0});
+            test.execute(BytesAssembled(9));
+            test.execute(UnassembledBytes(1));
+            test.execute(BytesAvailable("abcdefghi"));
+
+            test.execute(SubmitSegment{"jk", 9});
+            test.execute(SubmitSegment{"m", 12}.with_eof(true));
+            test.execute(BytesAssembled(13));
+            test.execute(UnassembledBytes(0));
+            test.execute(BytesAvailable("jklm"));
+            test.execute(AtEof{});
+        }
+
+        // an in-order substring that ends inside a stored one merges with it
+        {
+            ReassemblerTestHarness test{65000};
+
+            test.execute(SubmitSegment{"efgh", 4});
+            test.execute(SubmitBuffer{Buffer{string{"abcdef"}}, 0});
+            test.execute(BytesAssembled(8));
+            test.execute(UnassembledBytes(0));
+            test.execute(BytesAvailable("abcdefgh"));
+        }
+
+        // an in-order substring with EOF ends the stream even while later bytes are stored
+        {
+            ReassemblerTestHarness test{65000};
+
+            test.execute(SubmitSegment{"xyz", 10});
+            test.execute(SubmitSegment{"abc", 0}.with_eof(true));
+            test.execute(BytesAssembled(3));
+            test.execute(BytesAvailable("abc"));
+            test.execute(AtEof{});
+        }
+
+        // an in-order substring is cut at the window while a stored substring waits beyond the reassembled bytes
+        {
+            ReassemblerTestHarness test{8};
+
+            test.execute(SubmitSegment{"ab", 0});
+            test.execute(SubmitSegment{"gh", 6});
+            test.execute(SubmitSegment{"cdefghijkl", 2});
+            test.execute(BytesAssembled(8));
+            test.execute(UnassembledBytes(0));
+            test.execute(BytesAvailable("abcdefgh"));
+
+            test.execute(SubmitSegment{"ijkl", 8});
+            test.execute(BytesAvailable("ijkl"));
+        }
+
+        // the fast path writes the pushed Buffer without copying it while other substrings are stored
+        {
+            StreamReassembler reassembler{65000};
+            const Buffer data{string{"abcd"}};
+
+            reassembler.push_substring("gh", 6, false);
+            reassembler.push_substring(data, 0, false);
+            test_err_if(reassembler.unassembled_bytes() != 2, "the reassembler lost a stored substring");
+
+            const Buffer head = reassembler.stream_out().read_buffer(4);
+            test_err_if(head.str() != "abcd", "the reassembler reordered bytes");
+            test_err_if(head.str().data() != data.str().data(), "the reassembler copied the pushed Buffer");
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -159,6 +159,28 @@ struct SubmitSegment : public ReassemblerAction {
     void execute(StreamReassembler &reassembler) const { reassembler.push_substring(_data, _index, _eof); }
 };
 
+struct SubmitBuffer : public ReassemblerAction {
+    Buffer _data;
+    size_t _index;
+    bool _eof{false};
+
+    SubmitBuffer(const Buffer &data, size_t index) : _data(data), _index(index) {}
+
+    SubmitBuffer &with_eof(bool eof) {
+        _eof = eof;
+        return *this;
+    }
+
+    std::string description() const {
+        std::ostringstream ss;
+        ss << "Buffer submitted with data \"" << _data.str() << "\", index `" << _index << "`, eof `"
+           << std::to_string(_eof) << "`";
+        return ss.str();
+    }
+
+    void execute(StreamReassembler &reassembler) const { reassembler.push_substring(_data, _index, _eof); }
+};
+
 class ReassemblerTestHarness {
     StreamReassembler reassembler;
     std::vector<std::string> steps_executed;
@@ -0,0 +1,139 @@
+#include "buffer.hh"
+#include "byte_stream.hh"
+#include "fsm_stream_reassembler_harness.hh"
+#include "stream_reassembler.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+int main() {
+    try {
+        // a chain of overlapping substrings counts each byte once
+        {
+            ReassemblerTestHarness test{65000};
+
+            test.execute(SubmitSegment{"bc", 1});
+            test.execute(SubmitSegment{"cd", 2});
+            test.execute(SubmitSegment{"de", 3});
+            test.execute(UnassembledBytes(4));
+
+            // one that covers the whole chain and more replaces it
+            test.execute(SubmitSegment{"bcdefg", 1});
+            test.execute(UnassembledBytes(6));
+
+            // one that lies inside a stored substring adds nothing
+            test.execute(SubmitSegment{"cde", 2});
+            test.execute(UnassembledBytes(6));
+            test.execute(BytesAssembled(0));
+
+            test.execute(SubmitSegment{"a", 0});
+            test.execute(BytesAssembled(7));
+            test.execute(UnassembledBytes(0));
+            test.execute(BytesAvailable("abcdefg"));
+        }
+
+        // adjacent substrings are reassembled together once the gap before them is filled
+        {
+            ReassemblerTestHarness test{65000};
+
+            test.execute(SubmitSegment{"ef", 4});
+            test.execute(SubmitSegment{"cd", 2});
+            test.execute(SubmitSegment{"gh", 6});
+            test.execute(UnassembledBytes(6));
+            test.execute(BytesAssembled(0));
+
+            test.execute(SubmitSegment{"ab", 0});
+            test.execute(BytesAssembled(8));
+            test.execute(UnassembledBytes(0));
+            test.execute(BytesAvailable("abcdefgh"));
+        }
+
+        // a substring that overlaps one stored neighbour and touches the other fills the gap between them
+        {
+            ReassemblerTestHarness test{65000};
+
+            test.execute(SubmitSegment{"bc", 1});
+            test.execute(SubmitSegment{"gh", 6});
+            test.execute(SubmitSegment{"cdef", 2});
+            test.execute(UnassembledBytes(7));
+
+            test.execute(SubmitSegment{"a", 0});
+            test.execute(SubmitSegment{"hi", 7}.with_eof(true));
+            test.execute(BytesAssembled(9));
+            test.execute(UnassembledBytes(0));
+            test.execute(BytesAvailable("abcdefghi"));
+            test.execute(AtEof{});
+        }
+
+        // the unassembled ranges merge adjacent and overlapping substrings, and keep holes apart
+        {
+            StreamReassembler reassembler{65000};
+
+            reassembler.push_substring("cd", 2, false);
+            reassembler.push_substring("ef", 4, false);
+            reassembler.push_substring("de", 3, false);
+            reassembler.push_substring("ij", 8, false);
+            reassembler.push_substring("hi", 7, false);
+            reassembler.push_substring("m", 12, false);
+
+            const vector<pair<uint64_t, uint64_t>> expected{{2, 6}, {7, 10}, {12, 13}};
+            test_err_if(reassembler.unassembled_ranges() != expected, "wrong unassembled ranges");
+            test_err_if(reassembler.unassembled_bytes() != 8, "wrong number of unassembled bytes");
+        }
+
+        // an EOF that lies beyond the window is forgotten, and accepted once the window has moved
+        {
+            ReassemblerTestHarness test{4};
+
+            test.execute(SubmitSegment{"abcd", 0});
+            test.execute(SubmitSegment{"ef", 4}.with_eof(true));
+            test.execute(BytesAssembled(4));
+            test.execute(UnassembledBytes(0));
+            test.execute(BytesAvailable("abcd"));
+            test.execute(NotAtEof{});
+
+            // the earlier EOF does not end the stream when the bytes before it arrive without one
+            test.execute(SubmitSegment{"ef", 4});
+            test.execute(BytesAvailable("ef"));
+            test.execute(NotAtEof{});
+
+            test.execute(SubmitSegment{"g", 6}.with_eof(true));
+            test.execute(BytesAvailable("g"));
+            test.execute(AtEof{});
+        }
+
+        // an EOF beyond the window is dropped even when it arrives out of order in a Buffer
+        {
+            ReassemblerTestHarness test{4};
+
+            test.execute(SubmitSegment{"c", 2});
+            test.execute(SubmitBuffer{Buffer{string{"efg"}}, 4}.with_eof(true));
+            test.execute(UnassembledBytes(1));
+
+            test.execute(SubmitSegment{"abcd", 0});
+            test.execute(BytesAvailable("abcd"));
+            test.execute(NotAtEof{});
+
+            test.execute(SubmitBuffer{Buffer{string{"efg"}}, 4});
+            test.execute(BytesAvailable("efg"));
+            test.execute(NotAtEof{});
+
+            test.execute(SubmitBuffer{Buffer{string{"h"}}, 7}.with_eof(true));
+            test.execute(BytesAvailable("h"));
+            test.execute(AtEof{});
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,142 @@
+#include "tcp_config.hh"
+#include "tcp_expectation.hh"
+#include "tcp_fsm_test_harness.hh"
+#include "tcp_header.hh"
+#include "tcp_segment.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+using State = TCPTestHarness::State;
+
+//! Read one segment and check the timestamp it echoes
+static TCPSegment expect_echo(TCPTestHarness &test, const ExpectSegment &expectation, const uint32_t tsecr) {
+    TCPSegment seg = test.expect_seg(expectation);
+    test_err_if(not seg.header().timestamps.has_value(), "segment should carry timestamps");
+    test_err_if(seg.header().timestamps->tsecr != tsecr,
+                "segment echoed TSecr " + to_string(seg.header().timestamps->tsecr) + " instead of " +
+                    to_string(tsecr));
+    return seg;
+}
+
+//! A data segment from the peer, carrying a timestamp
+static SendSegment data_seg(const WrappingInt32 seqno, const WrappingInt32 ackno, string data, const uint32_t tsval) {
+    return SendSegment{}
+        .with_ack(true)
+        .with_seqno(seqno)
+        .with_ackno(ackno)
+        .with_win(1000)
+        .with_timestamps(tsval, 0)
+        .with_data(move(data));
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        TCPConfig cfg{};
+        cfg.timestamps = true;
+
+        // test 1: active open; TS.Recent follows the left edge of the window, and PAWS drops old duplicates
+        {
+            TCPTestHarness test_1(cfg);
+            test_1.execute(Connect{});
+            TCPSegment syn = test_1.expect_seg(ExpectOneSegment{}.with_syn(true).with_ack(false),
+                                               "test 1 failed: no SYN");
+            test_err_if(not syn.header().timestamps.has_value(), "test 1 failed: SYN should offer timestamps");
+            const WrappingInt32 tx_isn = syn.header().seqno;
+
+            test_1.execute(Tick(7));
+            const WrappingInt32 rx_isn(rd());
+            test_1.execute(SendSegment{}
+                               .with_syn(true)
+                               .with_ack(true)
+                               .with_seqno(rx_isn)
+                               .with_ackno(tx_isn + 1)
+                               .with_win(1000)
+                               .with_timestamps(1000, 0));
+            test_1.execute(ExpectState{State::ESTABLISHED});
+            TCPSegment ack = expect_echo(test_1, ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 1), 1000);
+            test_err_if(ack.header().timestamps->tsval != 7, "test 1 failed: TSval should be the sender's clock");
+
+            test_1.execute(data_seg(rx_isn + 1, tx_isn + 1, "abc", 1005));
+            expect_echo(test_1, ExpectOneSegment{}.with_ackno(rx_isn + 4), 1005);
+
+            // out of order: the echo still times the in-order data
+            test_1.execute(data_seg(rx_isn + 10, tx_isn + 1, "jkl", 1010));
+            expect_echo(test_1, ExpectOneSegment{}.with_ackno(rx_isn + 4), 1005);
+
+            test_1.execute(data_seg(rx_isn + 4, tx_isn + 1, "defghi", 1012));
+            expect_echo(test_1, ExpectOneSegment{}.with_ackno(rx_isn + 13), 1012);
+
+            // an old duplicate is acknowledged, but its data is not accepted
+            test_1.execute(data_seg(rx_isn + 13, tx_isn + 1, "zz", 900));
+            expect_echo(test_1, ExpectOneSegment{}.with_ackno(rx_isn + 13), 1012);
+            test_1.execute(ExpectUnassembledBytes{0});
+            test_1.execute(ExpectData{}.with_data("abcdefghijkl"));
+        }
+
+        // test 2: timestamps compare modulo 2^32
+        {
+            TCPTestHarness test_2 = TCPTestHarness::in_listen(cfg);
+            const WrappingInt32 rx_isn(rd());
+            test_2.execute(
+                SendSegment{}.with_syn(true).with_seqno(rx_isn).with_win(1000).with_timestamps(0xfffffff0, 0));
+            TCPSegment syn_ack = expect_echo(
+                test_2, ExpectOneSegment{}.with_syn(true).with_ack(true).with_ackno(rx_isn + 1), 0xfffffff0);
+            const WrappingInt32 tx_isn = syn_ack.header().seqno;
+
+            test_2.execute(data_seg(rx_isn + 1, tx_isn + 1, "abc", 0x10));
+            expect_echo(test_2, ExpectOneSegment{}.with_ackno(rx_isn + 4), 0x10);
+            test_2.execute(ExpectState{State::ESTABLISHED});
+            test_2.execute(ExpectData{}.with_data("abc"));
+        }
+
+        // test 3: the peer does not offer timestamps, so none are sent
+        {
+            TCPTestHarness test_3 = TCPTestHarness::in_listen(cfg);
+            const WrappingInt32 rx_isn(rd());
+            test_3.execute(SendSegment{}.with_syn(true).with_seqno(rx_isn).with_win(1000));
+            TCPSegment syn_ack = test_3.expect_seg(ExpectOneSegment{}.with_syn(true).with_ack(true),
+                                                   "test 3 failed: no SYN/ACK");
+            test_err_if(syn_ack.header().timestamps.has_value(),
+                        "test 3 failed: SYN/ACK offered timestamps to a peer that did not");
+        }
+
+        // test 4: with timestamps, only three SACK blocks fit in the options
+        {
+            TCPConfig sack_cfg = cfg;
+            sack_cfg.sack = true;
+            TCPTestHarness test_4 = TCPTestHarness::in_listen(sack_cfg);
+            const WrappingInt32 rx_isn(rd());
+            test_4.execute(SendSegment{}
+                               .with_syn(true)
+                               .with_seqno(rx_isn)
+                               .with_win(1000)
+                               .with_timestamps(1, 0)
+                               .with_sack_permitted(true));
+            TCPSegment syn_ack = expect_echo(test_4, ExpectOneSegment{}.with_syn(true).with_ack(true), 1);
+            test_err_if(not syn_ack.header().sack_permitted, "test 4 failed: SYN/ACK should permit SACK");
+            const WrappingInt32 tx_isn = syn_ack.header().seqno;
+
+            for (uint32_t i = 0; i < 4; i++) {
+                test_4.execute(data_seg(rx_isn + 3 + 2 * i, tx_isn + 1, "x", 2 + i));
+                TCPSegment sack_ack = expect_echo(test_4, ExpectOneSegment{}.with_ackno(rx_isn + 1), 1);
+                test_err_if(sack_ack.header().sack.size() != min<size_t>(i + 1, 3),
+                            "test 4 failed: wrong number of SACK blocks beside timestamps");
+                test_err_if(sack_ack.header().sack.front().left != rx_isn + 3 + 2 * i,
+                            "test 4 failed: the latest block should come first");
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return err_num;
+    }
+
+    return EXIT_SUCCESS;
+}
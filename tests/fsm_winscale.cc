@@ -0,0 +1,164 @@
+#include "tcp_config.hh"
+#include "tcp_expectation.hh"
+#include "tcp_fsm_test_harness.hh"
+#include "tcp_header.hh"
+#include "tcp_segment.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+using State = TCPTestHarness::State;
+
+static constexpr size_t BIG_CAPACITY = 1 << 20;  // needs a shift of 5 to fit in 16 bits
+static constexpr uint8_t BIG_SHIFT = 5;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        TCPConfig cfg{};
+        cfg.window_scaling = true;
+        cfg.recv_capacity = BIG_CAPACITY;
+        cfg.send_capacity = BIG_CAPACITY;
+
+        // test 1: active open, both sides scale; SYN windows are unscaled, later windows are scaled
+        {
+            TCPTestHarness test_1(cfg);
+            test_1.execute(Connect{});
+            TCPSegment syn = test_1.expect_seg(
+                ExpectOneSegment{}.with_syn(true).with_ack(false).with_win(UINT16_MAX).with_window_scale(BIG_SHIFT),
+                "test 1 failed: SYN should offer the window scale and saturate the window");
+            const WrappingInt32 tx_isn = syn.header().seqno;
+
+            const WrappingInt32 rx_isn(rd());
+            test_1.execute(SendSegment{}
+                               .with_syn(true)
+                               .with_ack(true)
+                               .with_seqno(rx_isn)
+                               .with_ackno(tx_isn + 1)
+                               .with_win(1000)
+                               .with_window_scale(2));
+            test_1.execute(ExpectState{State::ESTABLISHED});
+            test_1.execute(ExpectOneSegment{}
+                               .with_ack(true)
+                               .with_syn(false)
+                               .with_ackno(rx_isn + 1)
+                               .with_win(BIG_CAPACITY >> BIG_SHIFT),
+                           "test 1 failed: ACK should advertise the scaled window");
+
+            // the window on the SYN/ACK is taken as is
+            test_1.execute(Write{string(8000, 'x')});
+            test_1.execute(ExpectOneSegment{}.with_payload_size(1000), "test 1 failed: SYN/ACK window was scaled");
+
+            // 2000 << 2 bytes from the ackno
+            test_1.send_ack(rx_isn + 1, tx_isn + 1 + 1000, 2000);
+            for (unsigned i = 0; i < 7; i++) {
+                test_1.execute(ExpectSegment{}.with_payload_size(1000), "test 1 failed: scaled window not used");
+            }
+            test_1.execute(ExpectNoSegment{});
+            test_1.execute(ExpectBytesInFlight{7000});
+        }
+
+        // test 2: active open, the peer does not scale; windows are neither scaled nor wrapped
+        {
+            TCPTestHarness test_2(cfg);
+            test_2.execute(Connect{});
+            TCPSegment syn = test_2.expect_seg(ExpectOneSegment{}.with_syn(true).with_window_scale(BIG_SHIFT),
+                                               "test 2 failed: SYN should offer the window scale");
+            const WrappingInt32 tx_isn = syn.header().seqno;
+
+            const WrappingInt32 rx_isn(rd());
+            test_2.execute(
+                SendSegment{}.with_syn(true).with_ack(true).with_seqno(rx_isn).with_ackno(tx_isn + 1).with_win(1000));
+            TCPSegment ack =
+                test_2.expect_seg(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 1).with_win(UINT16_MAX),
+                                  "test 2 failed: unscaled window should saturate");
+            test_err_if(ack.header().window_scale.has_value(), "test 2 failed: window scale sent outside a SYN");
+
+            test_2.execute(Write{string(8000, 'x')});
+            test_2.execute(ExpectOneSegment{}.with_payload_size(1000));
+            test_2.send_ack(rx_isn + 1, tx_isn + 1 + 1000, 2000);
+            test_2.execute(ExpectSegment{}.with_payload_size(1000));
+            test_2.execute(ExpectSegment{}.with_payload_size(1000));
+            test_2.execute(ExpectNoSegment{}, "test 2 failed: window scaled without agreement");
+        }
+
+        // test 3: passive open, the peer scales; an oversized shift is capped
+        {
+            TCPTestHarness test_3(cfg);
+            test_3.execute(Listen{});
+            const WrappingInt32 rx_isn(rd());
+            test_3.execute(SendSegment{}.with_syn(true).with_seqno(rx_isn).with_win(1000).with_window_scale(20));
+            TCPSegment syn_ack = test_3.expect_seg(ExpectOneSegment{}
+                                                       .with_syn(true)
+                                                       .with_ack(true)
+                                                       .with_ackno(rx_isn + 1)
+                                                       .with_win(UINT16_MAX)
+                                                       .with_window_scale(BIG_SHIFT),
+                                                   "test 3 failed: SYN/ACK should answer the window scale");
+            const WrappingInt32 tx_isn = syn_ack.header().seqno;
+
+            test_3.send_ack(rx_isn + 1, tx_isn + 1, 1);
+            test_3.execute(ExpectState{State::ESTABLISHED});
+            test_3.execute(Write{string(BIG_CAPACITY, 'x')});
+            size_t bytes_sent = 0;
+            while (test_3.can_read()) {
+                bytes_sent += test_3.expect_seg(ExpectSegment{}).payload().size();
+            }
+            test_err_if(bytes_sent != 1 << TCPHeader::MAX_WINDOW_SCALE,
+                        "test 3 failed: shift count above 14 should be treated as 14");
+        }
+
+        // test 4: passive open, the peer does not scale, so neither do we
+        {
+            TCPTestHarness test_4(cfg);
+            test_4.execute(Listen{});
+            const WrappingInt32 rx_isn(rd());
+            test_4.execute(SendSegment{}.with_syn(true).with_seqno(rx_isn).with_win(1000));
+            TCPSegment syn_ack =
+                test_4.expect_seg(ExpectOneSegment{}.with_syn(true).with_ack(true).with_win(UINT16_MAX),
+                                  "test 4 failed: SYN/ACK invalid");
+            test_err_if(syn_ack.header().window_scale.has_value(),
+                        "test 4 failed: SYN/ACK offered window scale to a peer that did not");
+        }
+
+        // test 5: window scaling disabled locally; the peer's offer is ignored
+        {
+            TCPConfig plain_cfg = cfg;
+            plain_cfg.window_scaling = false;
+            TCPTestHarness test_5(plain_cfg);
+            test_5.execute(Listen{});
+            const WrappingInt32 rx_isn(rd());
+            test_5.execute(SendSegment{}.with_syn(true).with_seqno(rx_isn).with_win(1000).with_window_scale(3));
+            TCPSegment syn_ack =
+                test_5.expect_seg(ExpectOneSegment{}.with_syn(true).with_ack(true).with_win(UINT16_MAX),
+                                  "test 5 failed: SYN/ACK invalid");
+            test_err_if(syn_ack.header().window_scale.has_value(), "test 5 failed: window scale sent when disabled");
+            const WrappingInt32 tx_isn = syn_ack.header().seqno;
+
+            test_5.send_ack(rx_isn + 1, tx_isn + 1, 100);
+            test_5.execute(Write{string(1000, 'x')});
+            test_5.execute(ExpectOneSegment{}.with_payload_size(100), "test 5 failed: window scaled when disabled");
+        }
+
+        // test 6: a capacity that fits in 16 bits offers a shift of zero
+        {
+            TCPConfig small_cfg = cfg;
+            small_cfg.recv_capacity = 64000;
+            TCPTestHarness test_6(small_cfg);
+            test_6.execute(Connect{});
+            test_6.execute(ExpectOneSegment{}.with_syn(true).with_win(64000).with_window_scale(0),
+                           "test 6 failed: SYN should offer a shift of zero");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return err_num;
+    }
+
+    return EXIT_SUCCESS;
+}
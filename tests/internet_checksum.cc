@@ -0,0 +1,111 @@
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+using Kernel = InternetChecksum::Kernel;
+
+//! The checksum of `data`, summed one byte at a time as big-endian 16-bit words
+static uint16_t reference_checksum(const string_view data) {
+    uint64_t sum = 0;
+    for (size_t i = 0; i < data.size(); i++) {
+        const uint64_t byte = static_cast<uint8_t>(data[i]);
+        sum += i % 2 == 0 ? byte << 8 : byte;
+    }
+    while (sum > 0xffff) {
+        sum = (sum >> 16) + (sum & 0xffff);
+    }
+    return ~sum;
+}
+
+//! The checksum of `data` added in one call
+static uint16_t checksum(const Kernel kernel, const string_view data) {
+    InternetChecksum check{0, kernel};
+    check.add(data);
+    return check.value();
+}
+
+static string random_bytes(mt19937 &rd, const size_t len) {
+    string bytes(len, 0);
+    for (auto &byte : bytes) {
+        byte = static_cast<char>(rd());
+    }
+    return bytes;
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        const vector<pair<Kernel, string>> kernels{
+            {Kernel::Auto, "auto"}, {Kernel::Portable, "portable"}, {Kernel::SSE2, "SSE2"}, {Kernel::AVX2, "AVX2"}};
+
+        for (const auto &[kernel, name] : kernels) {
+            if (not InternetChecksum::supported(kernel)) {
+                cerr << "skipping the " << name << " kernel, which this CPU does not support\n";
+                continue;
+            }
+
+            // every length around the 8-, 16-, 32- and 64-byte steps of the kernels, at every alignment
+            const string bytes = random_bytes(rd, 300);
+            for (size_t offset = 0; offset < 8; offset++) {
+                for (size_t len = 0; offset + len <= bytes.size(); len++) {
+                    const string_view data = string_view(bytes).substr(offset, len);
+                    test_err_if(checksum(kernel, data) != reference_checksum(data),
+                                name + ": wrong checksum of " + to_string(len) + " bytes at offset " +
+                                    to_string(offset));
+                }
+            }
+
+            // random lengths, some long enough to need the vector lanes drained partway through
+            for (unsigned i = 0; i < 50; i++) {
+                const string data = random_bytes(rd, uniform_int_distribution<size_t>{0, 70000}(rd));
+                test_err_if(checksum(kernel, data) != reference_checksum(data),
+                            name + ": wrong checksum of " + to_string(data.size()) + " random bytes");
+            }
+            const string ones(1500000, '\xff');
+            test_err_if(checksum(kernel, ones) != reference_checksum(ones), name + ": lanes overflowed");
+            for (const size_t len : {1, 2, 3}) {
+                const string ones_tail(len, '\xff');
+                test_err_if(checksum(kernel, ones_tail) != reference_checksum(ones_tail),
+                            name + ": wrong checksum of " + to_string(len) + " 0xff bytes");
+            }
+
+            // adding in pieces, split at odd and even boundaries, gives the same result as adding at once
+            for (unsigned i = 0; i < 200; i++) {
+                const string data = random_bytes(rd, uniform_int_distribution<size_t>{0, 400}(rd));
+                InternetChecksum check{0, kernel};
+                size_t start = 0;
+                while (start < data.size()) {
+                    const size_t len = uniform_int_distribution<size_t>{0, 70}(rd);
+                    check.add(string_view(data).substr(start, len));
+                    start += len;
+                }
+                test_err_if(check.value() != reference_checksum(data),
+                            name + ": adding " + to_string(data.size()) + " bytes in pieces changed the checksum");
+            }
+        }
+
+        // the initial sum is added like any other word
+        {
+            InternetChecksum check{0x1234};
+            check.add("\x00\x01"s);
+            test_err_if(check.value() != static_cast<uint16_t>(~0x1235), "initial sum not added");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -13,6 +13,8 @@
 #include <optional>
 #include <sstream>
 #include <string>
+#include <utility>
+#include <vector>
 
 struct ReceiverTestStep {
     virtual std::string to_string() const { return "ReceiverTestStep"; }
@@ -68,6 +70,36 @@ struct ExpectAckno : public ReceiverExpectation {
     }
 };
 
+struct ExpectSACKBlocks : public ReceiverExpectation {
+    std::vector<SACKBlock> _blocks;
+
+    ExpectSACKBlocks(std::vector<SACKBlock> blocks) : _blocks(std::move(blocks)) {}
+
+    static std::string blocks_string(const std::vector<SACKBlock> &blocks) {
+        std::ostringstream ss;
+        ss << "[";
+        for (const auto &block : blocks) {
+            ss << (&block == &blocks.front() ? "" : " ") << block.left << "-" << block.right;
+        }
+        ss << "]";
+        return ss.str();
+    }
+
+    std::string description() const { return "SACK blocks " + blocks_string(_blocks); }
+
+    void execute(TCPReceiver &receiver) const {
+        const auto reported = receiver.sack_blocks();
+        const bool same = std::equal(
+            reported.begin(), reported.end(), _blocks.begin(), _blocks.end(), [](const auto &a, const auto &b) {
+                return a.left == b.left && a.right == b.right;
+            });
+        if (not same) {
+            throw ReceiverExpectationViolation("The TCPReceiver reported SACK blocks " + blocks_string(reported) +
+                                               ", but they were expected to be " + blocks_string(_blocks));
+        }
+    }
+};
+
 struct ExpectWindow : public ReceiverExpectation {
     size_t _window;
 
@@ -195,6 +227,7 @@ struct SegmentArrives : public ReceiverAction {
     WrappingInt32 seqno{0};
     WrappingInt32 ackno{0};
     uint16_t win{};
+    bool sack_permitted{};
     std::string data{};
     std::optional<Result> result{};
 
@@ -221,6 +254,11 @@ struct SegmentArrives : public ReceiverAction {
         return *this;
     }
 
+    SegmentArrives &with_sack_permitted() {
+        sack_permitted = true;
+        return *this;
+    }
+
     SegmentArrives &with_seqno(WrappingInt32 seqno_) {
         seqno = seqno_;
         return *this;
@@ -253,6 +291,7 @@ struct SegmentArrives : public ReceiverAction {
         seg.header().ackno = ackno;
         seg.header().seqno = seqno;
         seg.header().win = win;
+        seg.header().sack_permitted = sack_permitted;
         return seg;
     }
 
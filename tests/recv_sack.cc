@@ -0,0 +1,71 @@
+#include "receiver_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        {
+            uint32_t isn = uniform_int_distribution<uint32_t>{0, UINT32_MAX}(rd);
+            TCPReceiverTestHarness test{4000};
+            test.execute(SegmentArrives{}.with_syn().with_sack_permitted().with_seqno(isn).with_result(
+                SegmentArrives::Result::OK));
+            test.execute(ExpectSACKBlocks{{}});
+            test.execute(SegmentArrives{}.with_seqno(isn + 1).with_data("abcd"));
+            test.execute(ExpectAckno{WrappingInt32{isn + 5}});
+            test.execute(ExpectSACKBlocks{{}});
+        }
+
+        {
+            WrappingInt32 isn{uniform_int_distribution<uint32_t>{0, UINT32_MAX}(rd)};
+            TCPReceiverTestHarness test{4000};
+            test.execute(SegmentArrives{}.with_syn().with_sack_permitted().with_seqno(isn).with_result(
+                SegmentArrives::Result::OK));
+            test.execute(SegmentArrives{}.with_seqno(isn + 5).with_data("ef"));
+            test.execute(ExpectAckno{isn + 1});
+            test.execute(ExpectSACKBlocks{{{isn + 5, isn + 7}}});
+            test.execute(SegmentArrives{}.with_seqno(isn + 9).with_data("ij"));
+            test.execute(ExpectSACKBlocks{{{isn + 9, isn + 11}, {isn + 5, isn + 7}}});
+            test.execute(SegmentArrives{}.with_seqno(isn + 13).with_data("mn"));
+            test.execute(ExpectSACKBlocks{{{isn + 13, isn + 15}, {isn + 5, isn + 7}, {isn + 9, isn + 11}}});
+
+            // Filling a gap merges the blocks on either side
+            test.execute(SegmentArrives{}.with_seqno(isn + 7).with_data("gh"));
+            test.execute(ExpectSACKBlocks{{{isn + 5, isn + 11}, {isn + 13, isn + 15}}});
+            test.execute(SegmentArrives{}.with_seqno(isn + 1).with_data("abcd"));
+            test.execute(ExpectAckno{isn + 11});
+            test.execute(ExpectSACKBlocks{{{isn + 13, isn + 15}}});
+            test.execute(SegmentArrives{}.with_seqno(isn + 11).with_data("kl"));
+            test.execute(ExpectAckno{isn + 15});
+            test.execute(ExpectSACKBlocks{{}});
+            test.execute(ExpectBytes{"abcdefghijklmn"});
+        }
+
+        {
+            WrappingInt32 isn{uniform_int_distribution<uint32_t>{0, UINT32_MAX}(rd)};
+            TCPReceiverTestHarness test{4000};
+            test.execute(SegmentArrives{}.with_syn().with_sack_permitted().with_seqno(isn).with_result(
+                SegmentArrives::Result::OK));
+            for (uint32_t i = 0; i < 6; i++) {
+                test.execute(SegmentArrives{}.with_seqno(isn + 3 + 4 * i).with_data("xy"));
+            }
+            test.execute(
+                ExpectSACKBlocks{{{isn + 23, isn + 25}, {isn + 3, isn + 5}, {isn + 7, isn + 9}, {isn + 11, isn + 13}}});
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,197 @@
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        const size_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+        const uint16_t BIG_WIN = 60000;
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.congestion_control = TCPConfig::CongestionControl::NEWRENO;
+
+            TCPSenderTestHarness test{"NewReno sends an initial window of ten segments, then slow starts", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(BIG_WIN));
+            test.execute(ExpectCongestionWindow{10 * MSS});
+            test.execute(WriteBytes{string(20 * MSS, 'a')});
+            for (size_t i = 0; i < 10; i++) {
+                test.execute(ExpectSegment{}.with_no_flags().with_payload_size(MSS).with_seqno(isn + 1 + i * MSS));
+            }
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectBytesInFlight{10 * MSS});
+            test.execute(AckReceived{WrappingInt32{isn + 1 + MSS}}.with_win(BIG_WIN));
+            test.execute(ExpectCongestionWindow{11 * MSS});
+            test.execute(ExpectSegment{}.with_no_flags().with_payload_size(MSS).with_seqno(isn + 1 + 10 * MSS));
+            test.execute(ExpectSegment{}.with_no_flags().with_payload_size(MSS).with_seqno(isn + 1 + 11 * MSS));
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.congestion_control = TCPConfig::CongestionControl::NEWRENO;
+
+            TCPSenderTestHarness test{"NewReno respects a receiver window smaller than cwnd", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(4));
+            test.execute(WriteBytes{"abcdefg"});
+            test.execute(ExpectSegment{}.with_no_flags().with_data("abcd"));
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            uint16_t retx_timeout = uniform_int_distribution<uint16_t>{10, 10000}(rd);
+            cfg.fixed_isn = isn;
+            cfg.rt_timeout = retx_timeout;
+            cfg.congestion_control = TCPConfig::CongestionControl::NEWRENO;
+
+            TCPSenderTestHarness test{"NewReno collapses to one segment on timeout, then slow starts to ssthresh", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(BIG_WIN));
+            test.execute(WriteBytes{string(40 * MSS, 'a')});
+            for (size_t i = 0; i < 10; i++) {
+                test.execute(ExpectSegment{}.with_no_flags().with_payload_size(MSS).with_seqno(isn + 1 + i * MSS));
+            }
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{retx_timeout - 1u});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_no_flags().with_payload_size(MSS).with_seqno(isn + 1));
+            test.execute(ExpectCongestionWindow{MSS});
+
+            // ssthresh is now half of the 10 segments that were in flight
+            test.execute(AckReceived{WrappingInt32{isn + 1 + MSS}}.with_win(BIG_WIN));
+            test.execute(ExpectCongestionWindow{2 * MSS});
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 10 * MSS}}.with_win(BIG_WIN));
+            test.execute(ExpectCongestionWindow{3 * MSS});
+            for (size_t i = 10; i < 13; i++) {
+                test.execute(ExpectSegment{}.with_no_flags().with_payload_size(MSS).with_seqno(isn + 1 + i * MSS));
+            }
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 13 * MSS}}.with_win(BIG_WIN));
+            test.execute(ExpectCongestionWindow{4 * MSS});
+            for (size_t i = 13; i < 17; i++) {
+                test.execute(ExpectSegment{}.with_no_flags().with_payload_size(MSS).with_seqno(isn + 1 + i * MSS));
+            }
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 17 * MSS}}.with_win(BIG_WIN));
+            test.execute(ExpectCongestionWindow{5 * MSS});
+            for (size_t i = 17; i < 22; i++) {
+                test.execute(ExpectSegment{}.with_no_flags().with_payload_size(MSS).with_seqno(isn + 1 + i * MSS));
+            }
+            test.execute(ExpectNoSegment{});
+
+            // Congestion avoidance: one more segment per window's worth of acknowledgments
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 19 * MSS}}.with_win(BIG_WIN));
+            test.execute(ExpectCongestionWindow{5 * MSS});
+            test.execute(ExpectSegment{}.with_no_flags().with_payload_size(MSS).with_seqno(isn + 1 + 22 * MSS));
+            test.execute(ExpectSegment{}.with_no_flags().with_payload_size(MSS).with_seqno(isn + 1 + 23 * MSS));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 22 * MSS}}.with_win(BIG_WIN));
+            test.execute(ExpectCongestionWindow{6 * MSS});
+            for (size_t i = 24; i < 28; i++) {
+                test.execute(ExpectSegment{}.with_no_flags().with_payload_size(MSS).with_seqno(isn + 1 + i * MSS));
+            }
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            uint16_t retx_timeout = uniform_int_distribution<uint16_t>{10, 10000}(rd);
+            cfg.fixed_isn = isn;
+            cfg.rt_timeout = retx_timeout;
+            cfg.congestion_control = TCPConfig::CongestionControl::NEWRENO;
+
+            TCPSenderTestHarness test{"NewReno only reacts to the first of repeated timeouts", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(BIG_WIN));
+            test.execute(WriteBytes{string(10 * MSS, 'a')});
+            for (size_t i = 0; i < 10; i++) {
+                test.execute(ExpectSegment{}.with_no_flags().with_payload_size(MSS).with_seqno(isn + 1 + i * MSS));
+            }
+            test.execute(Tick{retx_timeout});
+            test.execute(ExpectSegment{}.with_no_flags().with_payload_size(MSS).with_seqno(isn + 1));
+            test.execute(Tick{2u * retx_timeout});
+            test.execute(ExpectSegment{}.with_no_flags().with_payload_size(MSS).with_seqno(isn + 1));
+            test.execute(ExpectCongestionWindow{MSS});
+
+            // ssthresh still reflects the 10 segments in flight at the first timeout
+            for (size_t i = 1; i <= 4; i++) {
+                test.execute(AckReceived{WrappingInt32{isn + 1 + i * MSS}}.with_win(BIG_WIN));
+                test.execute(ExpectCongestionWindow{(i + 1) * MSS});
+            }
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 5 * MSS}}.with_win(BIG_WIN));
+            test.execute(ExpectCongestionWindow{5 * MSS});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            uint16_t retx_timeout = uniform_int_distribution<uint16_t>{10, 10000}(rd);
+            cfg.fixed_isn = isn;
+            cfg.rt_timeout = retx_timeout;
+            cfg.congestion_control = TCPConfig::CongestionControl::CUBIC;
+
+            TCPSenderTestHarness test{"CUBIC slow starts, and backs off to 70% of the window on timeout", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(BIG_WIN));
+            test.execute(ExpectCongestionWindow{10 * MSS});
+            test.execute(WriteBytes{string(40 * MSS, 'a')});
+            for (size_t i = 0; i < 10; i++) {
+                test.execute(ExpectSegment{}.with_no_flags().with_payload_size(MSS).with_seqno(isn + 1 + i * MSS));
+            }
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{retx_timeout});
+            test.execute(ExpectSegment{}.with_no_flags().with_payload_size(MSS).with_seqno(isn + 1));
+            test.execute(ExpectCongestionWindow{MSS});
+            for (size_t i = 1; i <= 6; i++) {
+                test.execute(AckReceived{WrappingInt32{isn + 1 + i * MSS}}.with_win(BIG_WIN));
+                test.execute(ExpectCongestionWindow{(i + 1) * MSS});
+            }
+
+            // At ssthresh = 7 segments the cubic curve is flat, so only the Reno-friendly
+            // estimate grows, by 3(1-0.7)/(1+0.7)/7 of a segment per acknowledged segment
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 7 * MSS}}.with_win(BIG_WIN));
+            test.execute(ExpectCongestionWindow{7075});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+
+            TCPSenderTestHarness test{"Without congestion control, the whole receiver window is used", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(BIG_WIN));
+            test.execute(WriteBytes{string(40 * MSS, 'a')});
+            for (size_t i = 0; i < 40; i++) {
+                test.execute(ExpectSegment{}.with_no_flags().with_payload_size(MSS).with_seqno(isn + 1 + i * MSS));
+            }
+            test.execute(ExpectNoSegment{});
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
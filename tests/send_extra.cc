@@ -1,4 +1,5 @@
 #include "sender_harness.hh"
+#include "test_err_if.hh"
 #include "wrapping_integers.hh"
 
 #include <cstdint>
@@ -427,7 +428,8 @@ int main() {
             test.execute(AckReceived{WrappingInt32{isn + 12}}.with_win(1000));
             test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
             test.execute(Tick{5 * rto});
-            test.execute(ExpectSegment{}.with_payload_size(4).with_data("ijkl").with_seqno(isn + 8).with_fin(true));
+            // "ijkl" has been acknowledged, so only the FIN is retransmitted
+            test.execute(ExpectSegment{}.with_payload_size(0).with_seqno(isn + 12).with_fin(true));
             test.execute(ExpectNoSegment{});
             test.execute(AckReceived(WrappingInt32{isn + 13}).with_win(1000));
             test.execute(AckReceived(WrappingInt32{isn + 1}).with_win(1000));
@@ -435,6 +437,50 @@ int main() {
             test.execute(ExpectNoSegment{});
             test.execute(ExpectState{TCPSenderStateSummary::FIN_ACKED});
         }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            const size_t rto = uniform_int_distribution<uint16_t>{30, 10000}(rd);
+            cfg.fixed_isn = isn;
+            cfg.rt_timeout = rto;
+
+            TCPSenderTestHarness test{"A partial ACK trims the segment that is retransmitted", cfg};
+
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            test.execute(WriteBytes("abcdefgh"));
+            test.execute(ExpectSegment{}.with_payload_size(8).with_data("abcdefgh").with_seqno(isn + 1));
+            test.execute(AckReceived{WrappingInt32{isn + 4}}.with_win(1000));
+            test.execute(ExpectBytesInFlight{5});
+            test.execute(Tick{rto});
+            test.execute(ExpectSegment{}.with_payload_size(5).with_data("defgh").with_seqno(isn + 4));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 9}}.with_win(1000));
+            test.execute(ExpectBytesInFlight{0});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            const size_t rto = uniform_int_distribution<uint16_t>{30, 10000}(rd);
+            cfg.fixed_isn = isn;
+            cfg.rt_timeout = rto;
+
+            // a retransmission, rebuilt from the payload and its stored sum, is the same segment on the wire
+            TCPSender sender{cfg};
+            sender.fill_window();
+            sender.segments_out().pop();
+            sender.ack_received(isn + 1, 1000);
+            sender.stream_in().write("abcdefgh");
+            sender.fill_window();
+            const string original = sender.segments_out().front().serialize().concatenate();
+            sender.segments_out().pop();
+            sender.tick(rto);
+            test_err_if(sender.segments_out().size() != 1, "the segment was not retransmitted");
+            test_err_if(sender.segments_out().front().serialize().concatenate() != original,
+                        "the retransmission differs from the original segment");
+        }
     } catch (const exception &e) {
         cerr << e.what() << endl;
         return 1;
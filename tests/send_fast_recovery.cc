@@ -0,0 +1,208 @@
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        const size_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+        const uint16_t BIG_WIN = 60000;
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.congestion_control = TCPConfig::CongestionControl::NEWRENO;
+
+            TCPSenderTestHarness test{"Three duplicate ACKs trigger a fast retransmit and fast recovery", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(BIG_WIN));
+            test.execute(WriteBytes{string(20 * MSS, 'a')});
+            for (size_t i = 0; i < 10; i++) {
+                test.execute(ExpectSegment{}.with_no_flags().with_payload_size(MSS).with_seqno(isn + 1 + i * MSS));
+            }
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(BIG_WIN));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(BIG_WIN));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(BIG_WIN));
+            test.execute(ExpectSegment{}.with_no_flags().with_payload_size(MSS).with_seqno(isn + 1));
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectCongestionWindow{5 * MSS});
+            test.execute(ExpectBytesInFlight{10 * MSS});
+
+            // Each further duplicate ACK inflates the window by a segment, until new data can be sent
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(BIG_WIN));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(BIG_WIN));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(BIG_WIN));
+            test.execute(ExpectSegment{}.with_no_flags().with_payload_size(MSS).with_seqno(isn + 1 + 10 * MSS));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(BIG_WIN));
+            test.execute(ExpectSegment{}.with_no_flags().with_payload_size(MSS).with_seqno(isn + 1 + 11 * MSS));
+            test.execute(ExpectNoSegment{});
+
+            // A full ACK ends recovery with the window deflated to ssthresh
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 12 * MSS}}.with_win(BIG_WIN));
+            test.execute(ExpectCongestionWindow{5 * MSS});
+            for (size_t i = 12; i < 17; i++) {
+                test.execute(ExpectSegment{}.with_no_flags().with_payload_size(MSS).with_seqno(isn + 1 + i * MSS));
+            }
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.congestion_control = TCPConfig::CongestionControl::NEWRENO;
+
+            TCPSenderTestHarness test{"Partial ACKs during fast recovery retransmit the next hole", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(BIG_WIN));
+            test.execute(WriteBytes{string(20 * MSS, 'a')});
+            for (size_t i = 0; i < 10; i++) {
+                test.execute(ExpectSegment{}.with_no_flags().with_payload_size(MSS).with_seqno(isn + 1 + i * MSS));
+            }
+            for (size_t i = 0; i < 3; i++) {
+                test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(BIG_WIN));
+            }
+            test.execute(ExpectSegment{}.with_no_flags().with_payload_size(MSS).with_seqno(isn + 1));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 3 * MSS}}.with_win(BIG_WIN));
+            test.execute(ExpectSegment{}.with_no_flags().with_payload_size(MSS).with_seqno(isn + 1 + 3 * MSS));
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectBytesInFlight{7 * MSS});
+
+            // The window (5 segments of ssthresh, plus one) now has room for new data as well
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 7 * MSS}}.with_win(BIG_WIN));
+            test.execute(ExpectSegment{}.with_no_flags().with_payload_size(MSS).with_seqno(isn + 1 + 7 * MSS));
+            for (size_t i = 10; i < 13; i++) {
+                test.execute(ExpectSegment{}.with_no_flags().with_payload_size(MSS).with_seqno(isn + 1 + i * MSS));
+            }
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 10 * MSS}}.with_win(BIG_WIN));
+            test.execute(ExpectCongestionWindow{5 * MSS});
+            test.execute(ExpectBytesInFlight{5 * MSS});
+            for (size_t i = 13; i < 15; i++) {
+                test.execute(ExpectSegment{}.with_no_flags().with_payload_size(MSS).with_seqno(isn + 1 + i * MSS));
+            }
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.congestion_control = TCPConfig::CongestionControl::NEWRENO;
+
+            TCPSenderTestHarness test{"ACKs that update the window are not duplicates", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(BIG_WIN));
+            test.execute(WriteBytes{string(10 * MSS, 'a')});
+            for (size_t i = 0; i < 10; i++) {
+                test.execute(ExpectSegment{}.with_no_flags().with_payload_size(MSS).with_seqno(isn + 1 + i * MSS));
+            }
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(BIG_WIN - 1));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(BIG_WIN - 2));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(BIG_WIN - 3));
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectCongestionWindow{10 * MSS});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            uint16_t retx_timeout = uniform_int_distribution<uint16_t>{10, 10000}(rd);
+            cfg.fixed_isn = isn;
+            cfg.rt_timeout = retx_timeout;
+            cfg.congestion_control = TCPConfig::CongestionControl::CUBIC;
+
+            TCPSenderTestHarness test{"Duplicate ACKs for data sent before a timeout are ignored", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(BIG_WIN));
+            test.execute(WriteBytes{string(10 * MSS, 'a')});
+            for (size_t i = 0; i < 10; i++) {
+                test.execute(ExpectSegment{}.with_no_flags().with_payload_size(MSS).with_seqno(isn + 1 + i * MSS));
+            }
+            test.execute(Tick{retx_timeout});
+            test.execute(ExpectSegment{}.with_no_flags().with_payload_size(MSS).with_seqno(isn + 1));
+            for (size_t i = 0; i < 3; i++) {
+                test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(BIG_WIN));
+            }
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectCongestionWindow{MSS});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.congestion_control = TCPConfig::CongestionControl::CUBIC;
+
+            TCPSenderTestHarness test{"CUBIC fast retransmits and reduces the window by 30%", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(BIG_WIN));
+            test.execute(WriteBytes{string(10 * MSS, 'a')});
+            for (size_t i = 0; i < 10; i++) {
+                test.execute(ExpectSegment{}.with_no_flags().with_payload_size(MSS).with_seqno(isn + 1 + i * MSS));
+            }
+            for (size_t i = 0; i < 3; i++) {
+                test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(BIG_WIN));
+            }
+            test.execute(ExpectSegment{}.with_no_flags().with_payload_size(MSS).with_seqno(isn + 1));
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectCongestionWindow{7 * MSS});
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 10 * MSS}}.with_win(BIG_WIN));
+            test.execute(ExpectBytesInFlight{0});
+            test.execute(ExpectCongestionWindow{7 * MSS});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.fast_retransmit = true;
+
+            TCPSenderTestHarness test{"Fast retransmit works without congestion control", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(10 * MSS));
+            test.execute(WriteBytes{string(10 * MSS, 'a')});
+            for (size_t i = 0; i < 10; i++) {
+                test.execute(ExpectSegment{}.with_no_flags().with_payload_size(MSS).with_seqno(isn + 1 + i * MSS));
+            }
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(10 * MSS));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(10 * MSS));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(10 * MSS));
+            test.execute(ExpectSegment{}.with_no_flags().with_payload_size(MSS).with_seqno(isn + 1));
+            test.execute(ExpectNoSegment{});
+
+            // Further duplicate ACKs send nothing, since only the receiver's window limits the sender
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(10 * MSS));
+            test.execute(ExpectNoSegment{});
+
+            // A partial ACK retransmits the next hole at once
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 3 * MSS}}.with_win(10 * MSS));
+            test.execute(ExpectSegment{}.with_no_flags().with_payload_size(MSS).with_seqno(isn + 1 + 3 * MSS));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 10 * MSS}}.with_win(10 * MSS));
+            test.execute(ExpectBytesInFlight{0});
+            test.execute(ExpectNoSegment{});
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,130 @@
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.pacing = true;
+            cfg.pacing_rate = 100000;  // 100 bytes per ms
+
+            TCPSenderTestHarness test{"A configured rate releases one segment per 10 ms", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(10000));
+            test.execute(WriteBytes{string(5000, 'x')});
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1));
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{5});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{5});
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1001));
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{10});
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 2001));
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectBytesInFlight{3000});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.pacing = true;
+            cfg.pacing_rate = 100000;
+
+            TCPSenderTestHarness test{"Credit saved while idle is capped at two segments", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(10000));
+            for (unsigned i = 0; i < 10; i++) {
+                test.execute(Tick{10});
+            }
+            test.execute(WriteBytes{string(5000, 'x')});
+            for (unsigned i = 0; i < 3; i++) {
+                test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1 + 1000 * i));
+            }
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.pacing = true;
+            cfg.pacing_rate = 100000;
+            cfg.send_capacity = 200000;
+
+            TCPSenderTestHarness test{"One long tick saves no more credit than many short ones", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+            test.execute(Tick{5000});
+            test.execute(WriteBytes{string(200000, 'x')});
+            for (unsigned i = 0; i < 3; i++) {
+                test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1 + 1000 * i));
+            }
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectBytesInFlight{3000});
+
+            // and after the burst, the rate holds
+            test.execute(Tick{10});
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 3001));
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.pacing = true;
+            cfg.congestion_control = TCPConfig::CongestionControl::NEWRENO;
+
+            TCPSenderTestHarness test{"The derived rate is twice the window per SRTT in slow start", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(Tick{100});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(20000));
+
+            // 2 * min(cwnd 10000, window 20000) per 100 ms: 200 bytes per ms
+            test.execute(WriteBytes{string(10000, 'x')});
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1));
+            test.execute(ExpectNoSegment{});
+            for (unsigned i = 1; i < 4; i++) {
+                test.execute(Tick{5});
+                test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1 + 1000 * i));
+                test.execute(ExpectNoSegment{});
+            }
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.pacing = true;
+
+            TCPSenderTestHarness test{"Without an RTT sample the derived rate does not pace", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(Tick{1000});
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(20000));
+            test.execute(WriteBytes{string(3000, 'x')});
+            for (unsigned i = 0; i < 3; i++) {
+                test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1 + 1000 * i));
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,143 @@
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.adaptive_rto = true;
+            cfg.rto_min = 10;
+
+            TCPSenderTestHarness test{"The first RTT sample sets the RTO to 3 * RTT", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(Tick{50});
+            test.execute(AckReceived{WrappingInt32{isn + 1}});
+            test.execute(WriteBytes{"abc"});
+            test.execute(ExpectSegment{}.with_no_flags().with_data("abc").with_seqno(isn + 1));
+            test.execute(Tick{149});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_no_flags().with_data("abc").with_seqno(isn + 1));
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.adaptive_rto = true;
+            cfg.rto_min = 10;
+
+            TCPSenderTestHarness test{"Later samples are smoothed into SRTT and RTTVAR", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(Tick{50});
+            test.execute(AckReceived{WrappingInt32{isn + 1}});
+            test.execute(WriteBytes{"abc"});
+            test.execute(ExpectSegment{}.with_no_flags().with_data("abc").with_seqno(isn + 1));
+            test.execute(Tick{10});
+            test.execute(AckReceived{WrappingInt32{isn + 4}});
+
+            // RTTVAR = 3/4 * 25 + 1/4 * |50 - 10| = 28.75, SRTT = 7/8 * 50 + 1/8 * 10 = 45
+            test.execute(WriteBytes{"def"});
+            test.execute(ExpectSegment{}.with_no_flags().with_data("def").with_seqno(isn + 4));
+            test.execute(Tick{159});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_no_flags().with_data("def").with_seqno(isn + 4));
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.adaptive_rto = true;
+            cfg.rto_min = 10;
+
+            TCPSenderTestHarness test{"Karn's algorithm: an ACK of a retransmission gives no sample", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(Tick{50});
+            test.execute(AckReceived{WrappingInt32{isn + 1}});
+            test.execute(WriteBytes{"abc"});
+            test.execute(ExpectSegment{}.with_no_flags().with_data("abc").with_seqno(isn + 1));
+            test.execute(Tick{150});
+            test.execute(ExpectSegment{}.with_no_flags().with_data("abc").with_seqno(isn + 1));
+            test.execute(Tick{100});
+            test.execute(AckReceived{WrappingInt32{isn + 4}});
+
+            // The backed-off RTO of 300 ms is kept until an unambiguous sample arrives
+            test.execute(WriteBytes{"def"});
+            test.execute(ExpectSegment{}.with_no_flags().with_data("def").with_seqno(isn + 4));
+            test.execute(Tick{299});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_no_flags().with_data("def").with_seqno(isn + 4));
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.adaptive_rto = true;
+            cfg.rto_min = 10;
+
+            TCPSenderTestHarness test{"A timestamp echo gives a sample even for a retransmission", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(Tick{50});
+            test.execute(AckReceived{WrappingInt32{isn + 1}});
+            test.execute(WriteBytes{"abc"});
+            test.execute(ExpectSegment{}.with_no_flags().with_data("abc").with_seqno(isn + 1));
+            test.execute(Tick{150});
+            test.execute(ExpectSegment{}.with_no_flags().with_data("abc").with_seqno(isn + 1));
+            test.execute(Tick{20});
+            test.execute(AckReceived{WrappingInt32{isn + 4}}.with_tsecr(200));
+
+            // RTTVAR = 3/4 * 25 + 1/4 * |50 - 20| = 26.25, SRTT = 7/8 * 50 + 1/8 * 20 = 46.25, RTO = ceil(151.25)
+            test.execute(WriteBytes{"def"});
+            test.execute(ExpectSegment{}.with_no_flags().with_data("def").with_seqno(isn + 4));
+            test.execute(Tick{151});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_no_flags().with_data("def").with_seqno(isn + 4));
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.adaptive_rto = true;
+            cfg.rto_min = 100;
+            cfg.rto_max = 400;
+
+            TCPSenderTestHarness test{"The RTO is clamped between rto_min and rto_max", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(Tick{1});
+            test.execute(AckReceived{WrappingInt32{isn + 1}});
+            test.execute(WriteBytes{"abc"});
+            test.execute(ExpectSegment{}.with_no_flags().with_data("abc").with_seqno(isn + 1));
+            for (unsigned rto : {100, 200, 400, 400, 400}) {
+                test.execute(Tick{rto - 1});
+                test.execute(ExpectNoSegment{});
+                test.execute(Tick{1});
+                test.execute(ExpectSegment{}.with_no_flags().with_data("abc").with_seqno(isn + 1));
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,114 @@
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        const size_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+        const uint16_t BIG_WIN = 60000;
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.congestion_control = TCPConfig::CongestionControl::NEWRENO;
+
+            TCPSenderTestHarness test{"Every SACKed hole is retransmitted once, without resending SACKed data", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(BIG_WIN));
+            test.execute(WriteBytes{string(10 * MSS, 'a')});
+            for (size_t i = 0; i < 10; i++) {
+                test.execute(ExpectSegment{}.with_no_flags().with_payload_size(MSS).with_seqno(isn + 1 + i * MSS));
+            }
+
+            // Three segments SACKed above the first mark it lost straight away
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(BIG_WIN).with_sack(isn + 1 + MSS,
+                                                                                          isn + 1 + 4 * MSS));
+            test.execute(ExpectSegment{}.with_no_flags().with_payload_size(MSS).with_seqno(isn + 1));
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectCongestionWindow{5 * MSS});
+
+            // A second hole is repaired as soon as it is reported
+            test.execute(AckReceived{WrappingInt32{isn + 1}}
+                             .with_win(BIG_WIN)
+                             .with_sack(isn + 1 + 5 * MSS, isn + 1 + 8 * MSS)
+                             .with_sack(isn + 1 + MSS, isn + 1 + 4 * MSS));
+            test.execute(ExpectSegment{}.with_no_flags().with_payload_size(MSS).with_seqno(isn + 1 + 4 * MSS));
+            test.execute(ExpectNoSegment{});
+
+            // The partial ACK finds that hole already repaired
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 4 * MSS}}.with_win(BIG_WIN).with_sack(
+                isn + 1 + 5 * MSS, isn + 1 + 8 * MSS));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 10 * MSS}}.with_win(BIG_WIN));
+            test.execute(ExpectBytesInFlight{0});
+            test.execute(ExpectCongestionWindow{5 * MSS});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            uint16_t retx_timeout = uniform_int_distribution<uint16_t>{10, 10000}(rd);
+            cfg.fixed_isn = isn;
+            cfg.rt_timeout = retx_timeout;
+
+            TCPSenderTestHarness test{"Without congestion control, SACK still repairs holes early", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(BIG_WIN));
+            test.execute(WriteBytes{string(5 * MSS, 'a')});
+            for (size_t i = 0; i < 5; i++) {
+                test.execute(ExpectSegment{}.with_no_flags().with_payload_size(MSS).with_seqno(isn + 1 + i * MSS));
+            }
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(BIG_WIN).with_sack(isn + 1 + MSS,
+                                                                                          isn + 1 + 4 * MSS));
+            test.execute(ExpectSegment{}.with_no_flags().with_payload_size(MSS).with_seqno(isn + 1));
+            test.execute(ExpectNoSegment{});
+
+            // The timer still backs up the repair, and only ever resends the oldest segment
+            test.execute(Tick{retx_timeout});
+            test.execute(ExpectSegment{}.with_no_flags().with_payload_size(MSS).with_seqno(isn + 1));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 5 * MSS}}.with_win(BIG_WIN));
+            test.execute(ExpectBytesInFlight{0});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.congestion_control = TCPConfig::CongestionControl::NEWRENO;
+
+            TCPSenderTestHarness test{"Too little SACKed data, or SACKs outside the window, mark nothing lost", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(BIG_WIN));
+            test.execute(WriteBytes{string(10 * MSS, 'a')});
+            for (size_t i = 0; i < 10; i++) {
+                test.execute(ExpectSegment{}.with_no_flags().with_payload_size(MSS).with_seqno(isn + 1 + i * MSS));
+            }
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(BIG_WIN - 1).with_sack(isn + 1 + MSS,
+                                                                                              isn + 1 + 3 * MSS));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(BIG_WIN - 2).with_sack(isn + 1 + 20 * MSS,
+                                                                                              isn + 1 + 30 * MSS));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(BIG_WIN - 3).with_sack(isn, isn + 1 + 4 * MSS));
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectCongestionWindow{10 * MSS});
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -15,6 +15,7 @@
 #include <optional>
 #include <sstream>
 #include <string>
+#include <vector>
 
 const unsigned int DEFAULT_TEST_WINDOW = 137;
 
@@ -99,6 +100,26 @@ struct ExpectBytesInFlight : public SenderExpectation {
     }
 };
 
+struct ExpectCongestionWindow : public SenderExpectation {
+    size_t _cwnd;
+
+    ExpectCongestionWindow(size_t cwnd) : _cwnd(cwnd) {}
+    std::string description() const { return "congestion window of " + std::to_string(_cwnd) + " bytes"; }
+
+    void execute(TCPSender &sender, std::queue<TCPSegment> &) const {
+        if (sender.congestion_control() == nullptr) {
+            throw SenderExpectationViolation("The TCPSender has no congestion control, but a congestion window of " +
+                                             std::to_string(_cwnd) + " bytes was expected");
+        }
+        if (sender.congestion_control()->cwnd() != _cwnd) {
+            std::ostringstream ss;
+            ss << "The TCPSender reported a congestion window of " << sender.congestion_control()->cwnd()
+               << " bytes, but it was expected to be " << _cwnd << " bytes";
+            throw SenderExpectationViolation(ss.str());
+        }
+    }
+};
+
 struct ExpectNoSegment : public SenderExpectation {
     ExpectNoSegment() {}
     std::string description() const { return "no (more) segments"; }
@@ -191,11 +212,19 @@ struct Tick : public SenderAction {
 struct AckReceived : public SenderAction {
     WrappingInt32 _ackno;
     std::optional<uint16_t> _window_advertisement{};
+    std::vector<SACKBlock> _sack{};
+    std::optional<uint32_t> _tsecr{};
 
     AckReceived(WrappingInt32 ackno) : _ackno(ackno) {}
     std::string description() const {
         std::ostringstream ss;
         ss << "ack " << _ackno.raw_value() << " winsize " << _window_advertisement.value_or(DEFAULT_TEST_WINDOW);
+        for (const auto &block : _sack) {
+            ss << " sack " << block.left << "-" << block.right;
+        }
+        if (_tsecr.has_value()) {
+            ss << " tsecr " << _tsecr.value();
+        }
         return ss.str();
     }
 
@@ -204,8 +233,18 @@ struct AckReceived : public SenderAction {
         return *this;
     }
 
+    AckReceived &with_sack(WrappingInt32 left, WrappingInt32 right) {
+        _sack.push_back({left, right});
+        return *this;
+    }
+
+    AckReceived &with_tsecr(uint32_t tsecr) {
+        _tsecr = tsecr;
+        return *this;
+    }
+
     void execute(TCPSender &sender, std::queue<TCPSegment> &) const {
-        sender.ack_received(_ackno, _window_advertisement.value_or(DEFAULT_TEST_WINDOW));
+        sender.ack_received(_ackno, _window_advertisement.value_or(DEFAULT_TEST_WINDOW), true, _sack, _tsecr);
         sender.fill_window();
     }
 };
@@ -394,7 +433,7 @@ class TCPSenderTestHarness {
   public:
     TCPSenderTestHarness(const std::string &name_, TCPConfig config)
         : outbound_segments()
-        , sender(config.send_capacity, config.rt_timeout, config.fixed_isn)
+        , sender(config)
         , steps_executed()
         , name(name_) {
         sender.fill_window();
@@ -0,0 +1,102 @@
+#include "tcp_segment.hh"
+#include "test_err_if.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//! An ACK-bearing data segment starting at `seqno`
+static TCPSegment data_segment(const uint32_t seqno, const string &payload) {
+    TCPSegment seg;
+    seg.header().ack = true;
+    seg.header().ackno = WrappingInt32{7};
+    seg.header().win = 1000;
+    seg.header().seqno = WrappingInt32{seqno};
+    seg.payload() = string(payload);
+    return seg;
+}
+
+//! The payloads of a run, in order
+static string joined(const vector<TCPSegment> &run) {
+    string ret;
+    for (const auto &seg : run) {
+        ret.append(seg.payload().str());
+    }
+    return ret;
+}
+
+int main() {
+    try {
+        {
+            // contiguous segments form one run, and seqnos may wrap between them
+            vector<TCPSegment> segs{data_segment(UINT32_MAX - 1, "ab"), data_segment(0, "cde"), data_segment(3, "f")};
+            segs.back().header().psh = true;
+
+            const char *const first_payload = segs[0].payload().str().data();
+
+            const auto runs = TCPSegment::coalesce(segs, 1000);
+            test_err_if(runs.size() != 1, "contiguous segments should form one run");
+            test_err_if(runs[0].size() != 3, "the run should keep every segment");
+            test_err_if(joined(runs[0]) != "abcdef", "the run's payload is wrong");
+            test_err_if(runs[0][0].header().seqno != WrappingInt32{UINT32_MAX - 1}, "the run's seqno is wrong");
+            test_err_if(not runs[0][2].header().psh, "PSH on the last segment should be kept");
+            test_err_if(runs[0][0].payload().str().data() != first_payload, "a payload was copied");
+        }
+
+        {
+            // a gap, a different ackno, PSH and FIN all end a run
+            vector<TCPSegment> segs{data_segment(0, "ab"),
+                                    data_segment(2, "cd"),
+                                    data_segment(10, "kl"),
+                                    data_segment(12, "mn"),
+                                    data_segment(14, "op"),
+                                    data_segment(16, "qr"),
+                                    data_segment(18, "st")};
+            segs[2].header().ackno = WrappingInt32{8};
+            segs[4].header().psh = true;
+            segs[6].header().fin = true;
+
+            const auto runs = TCPSegment::coalesce(segs, 1000);
+            const vector<string> expected{"abcd", "kl", "mnop", "qr", "st"};
+            test_err_if(runs.size() != expected.size(), "wrong number of runs");
+            for (size_t i = 0; i < expected.size(); i++) {
+                test_err_if(joined(runs[i]) != expected[i], "run " + to_string(i) + " has the wrong data");
+            }
+            test_err_if(not runs[2].back().header().psh or not runs[4].back().header().fin, "flags were lost");
+        }
+
+        {
+            // differing options, or payload past the limit, keep segments apart
+            vector<TCPSegment> segs{data_segment(0, "ab"), data_segment(2, "cd"), data_segment(4, "ef")};
+            segs[1].header().sack.push_back({WrappingInt32{20}, WrappingInt32{30}});
+            test_err_if(TCPSegment::coalesce(segs, 1000).size() != 3, "segments with different SACK merged");
+
+            segs[1].header().sack.clear();
+            segs[0].header().timestamps = TCPTimestamps{1, 2};
+            test_err_if(TCPSegment::coalesce(segs, 1000).size() != 2, "segments with different timestamps merged");
+
+            segs[0].header().timestamps.reset();
+            const auto runs = TCPSegment::coalesce(segs, 5);
+            test_err_if(runs.size() != 2 or joined(runs[0]) != "abcd", "the payload limit was ignored");
+        }
+
+        {
+            // pure ACKs and empty batches pass through
+            TCPSegment ack;
+            ack.header().ack = true;
+            test_err_if(TCPSegment::coalesce({ack, ack}, 1000).size() != 2, "pure ACKs should not form a run");
+            test_err_if(not TCPSegment::coalesce({}, 1000).empty(), "an empty batch should stay empty");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -11,6 +11,7 @@
 #include <exception>
 #include <optional>
 #include <sstream>
+#include <vector>
 
 struct TCPExpectation : public TCPTestStep {
     virtual ~TCPExpectation() {}
@@ -121,6 +122,7 @@ struct ExpectSegment : public TCPExpectation {
     std::optional<WrappingInt32> seqno{};
     std::optional<WrappingInt32> ackno{};
     std::optional<uint16_t> win{};
+    std::optional<uint8_t> window_scale{};
     std::optional<size_t> payload_size{};
     std::optional<std::string> data{};
 
@@ -171,6 +173,11 @@ struct ExpectSegment : public TCPExpectation {
         return *this;
     }
 
+    ExpectSegment &with_window_scale(uint8_t window_scale_) {
+        window_scale = window_scale_;
+        return *this;
+    }
+
     ExpectSegment &with_payload_size(size_t payload_size_) {
         payload_size = payload_size_;
         return *this;
@@ -202,6 +209,9 @@ struct ExpectSegment : public TCPExpectation {
         if (win.has_value()) {
             o << "win=" << win.value() << ",";
         }
+        if (window_scale.has_value()) {
+            o << "wscale=" << +window_scale.value() << ",";
+        }
         if (seqno.has_value()) {
             o << "seqno=" << seqno.value() << ",";
         }
@@ -248,6 +258,10 @@ struct ExpectSegment : public TCPExpectation {
         if (win.has_value() and seg.header().win != win.value()) {
             throw SegmentExpectationViolation::violated_field("win", win.value(), seg.header().win);
         }
+        if (window_scale.has_value() and seg.header().window_scale != window_scale) {
+            throw SegmentExpectationViolation::violated_field(
+                "window_scale", +window_scale.value(), +seg.header().window_scale.value_or(0));
+        }
         if (payload_size.has_value() and seg.payload().size() != payload_size.value()) {
             throw SegmentExpectationViolation::violated_field(
                 "payload_size", payload_size.value(), seg.payload().size());
@@ -387,9 +401,14 @@ struct SendSegment : public TCPAction {
     bool rst{false};
     bool syn{false};
     bool fin{false};
+    bool psh{false};
     WrappingInt32 seqno{0};
     WrappingInt32 ackno{0};
     uint16_t win{0};
+    std::optional<uint16_t> mss{};
+    std::optional<uint8_t> window_scale{};
+    std::optional<TCPTimestamps> timestamps{};
+    bool sack_permitted{false};
     size_t payload_size{0};
     std::string data{};
 
@@ -400,9 +419,14 @@ struct SendSegment : public TCPAction {
         rst = seg.header().rst;
         syn = seg.header().syn;
         fin = seg.header().fin;
+        psh = seg.header().psh;
         seqno = seg.header().seqno;
         ackno = seg.header().ackno;
         win = seg.header().win;
+        mss = seg.header().mss;
+        window_scale = seg.header().window_scale;
+        timestamps = seg.header().timestamps;
+        sack_permitted = seg.header().sack_permitted;
         data = seg.payload();
     }
 
@@ -426,6 +450,11 @@ struct SendSegment : public TCPAction {
         return *this;
     }
 
+    SendSegment &with_psh(bool psh_) {
+        psh = psh_;
+        return *this;
+    }
+
     SendSegment &with_seqno(WrappingInt32 seqno_) {
         seqno = seqno_;
         return *this;
@@ -445,6 +474,26 @@ struct SendSegment : public TCPAction {
         return *this;
     }
 
+    SendSegment &with_mss(uint16_t mss_) {
+        mss = mss_;
+        return *this;
+    }
+
+    SendSegment &with_window_scale(uint8_t window_scale_) {
+        window_scale = window_scale_;
+        return *this;
+    }
+
+    SendSegment &with_timestamps(uint32_t tsval, uint32_t tsecr) {
+        timestamps = TCPTimestamps{tsval, tsecr};
+        return *this;
+    }
+
+    SendSegment &with_sack_permitted(bool sack_permitted_) {
+        sack_permitted = sack_permitted_;
+        return *this;
+    }
+
     SendSegment &with_payload_size(size_t payload_size_) {
         payload_size = payload_size_;
         return *this;
@@ -463,9 +512,14 @@ struct SendSegment : public TCPAction {
         data_hdr.rst = rst;
         data_hdr.syn = syn;
         data_hdr.fin = fin;
+        data_hdr.psh = psh;
         data_hdr.ackno = ackno;
         data_hdr.seqno = seqno;
         data_hdr.win = win;
+        data_hdr.mss = mss;
+        data_hdr.window_scale = window_scale;
+        data_hdr.timestamps = timestamps;
+        data_hdr.sack_permitted = sack_permitted;
         return data_seg;
     }
 
@@ -489,6 +543,30 @@ struct SendSegment : public TCPAction {
     }
 };
 
+//! A run of segments (see TCPSegment::coalesce()) arriving together, handed over as one
+struct SendRun : public TCPAction {
+    std::vector<SendSegment> segments;
+
+    SendRun(std::vector<SendSegment> segments_) : segments(std::move(segments_)) {}
+
+    std::string description() const {
+        std::ostringstream o;
+        o << "run of " << segments.size() << " packets arrives:";
+        for (const auto &seg : segments) {
+            o << "\n\t\t" << seg.description();
+        }
+        return o.str();
+    }
+
+    void execute(TCPTestHarness &harness) const {
+        std::vector<TCPSegment> run;
+        for (const auto &seg : segments) {
+            run.push_back(seg.get_segment());
+        }
+        harness._fsm.segments_received(run);
+    }
+};
+
 struct Write : public TCPAction {
     std::string data;
     std::optional<size_t> _bytes_written{};
@@ -564,4 +642,19 @@ struct Close : public TCPAction {
     void execute(TCPTestHarness &harness) const { harness._fsm.end_input_stream(); }
 };
 
+struct Cork : public TCPAction {
+    std::string description() const { return "cork"; }
+    void execute(TCPTestHarness &harness) const { harness._fsm.cork(); }
+};
+
+struct Uncork : public TCPAction {
+    std::string description() const { return "uncork"; }
+    void execute(TCPTestHarness &harness) const { harness._fsm.uncork(); }
+};
+
+struct Flush : public TCPAction {
+    std::string description() const { return "flush"; }
+    void execute(TCPTestHarness &harness) const { harness._fsm.flush(); }
+};
+
 #endif  // SPONGE_LIBSPONGE_TCP_EXPECTATION_HH
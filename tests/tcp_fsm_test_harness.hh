@@ -31,8 +31,9 @@ class TestFD : public FileDescriptor {
 
     TestRFD _recv_fd;  //!< The end of a SOCK_SEQPACKET socket pair from which TCPTestHarness reads
 
-    //! Max-sized segment plus some margin
-    static constexpr size_t MAX_RECV = TCPConfig::MAX_PAYLOAD_SIZE + TCPHeader::LENGTH + 16;
+    //! Max-sized segment with options, plus some margin
+    static constexpr size_t MAX_RECV =
+        TCPConfig::MAX_PAYLOAD_SIZE + TCPHeader::LENGTH + TCPHeader::MAX_OPTIONS_LENGTH + 16;
 
     //! Construct from a pair of sockets
     explicit TestFD(std::pair<FileDescriptor, TestRFD> fd_pair);
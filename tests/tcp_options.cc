@@ -0,0 +1,153 @@
+#include "tcp_header.hh"
+#include "tcp_segment.hh"
+#include "test_err_if.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+static TCPHeader parse_header(const string &bytes) {
+    TCPHeader header;
+    NetParser p{string(bytes)};
+    const ParseResult res = header.parse(p);
+    test_err_if(res != ParseResult::NoError, "header failed to parse: " + as_string(res));
+    return header;
+}
+
+static string raw_header(const uint8_t doff, const string &options) {
+    TCPHeader header;
+    header.doff = doff;
+    string ret = header.serialize();
+    ret.replace(TCPHeader::LENGTH, options.size(), options);
+    return ret;
+}
+
+int main() {
+    try {
+        {
+            TCPSegment seg;
+            seg.header().syn = true;
+            seg.header().seqno = WrappingInt32{12345};
+            seg.header().sack_permitted = true;
+            seg.payload() = string("hello");
+
+            TCPSegment parsed;
+            test_err_if(parsed.parse(seg.serialize().concatenate()) != ParseResult::NoError,
+                        "SYN with SACK-permitted failed to parse");
+            test_err_if(not parsed.header().sack_permitted, "SACK-permitted was lost");
+            test_err_if(parsed.header().doff != 6, "SACK-permitted should pad the header to 24 bytes");
+            test_err_if(parsed.payload().str() != "hello", "payload was corrupted by the options");
+        }
+
+        {
+            TCPSegment seg;
+            seg.header().ack = true;
+            seg.header().ackno = WrappingInt32{100};
+            for (uint32_t i = 0; i < TCPHeader::MAX_SACK_BLOCKS + 1; i++) {
+                seg.header().sack.push_back({WrappingInt32{200 + 100 * i}, WrappingInt32{250 + 100 * i}});
+            }
+
+            TCPSegment parsed;
+            test_err_if(parsed.parse(seg.serialize().concatenate()) != ParseResult::NoError,
+                        "ACK with SACK blocks failed to parse");
+            const auto &sack = parsed.header().sack;
+            test_err_if(sack.size() != TCPHeader::MAX_SACK_BLOCKS, "only MAX_SACK_BLOCKS blocks should be sent");
+            for (uint32_t i = 0; i < sack.size(); i++) {
+                test_err_if(sack[i].left != WrappingInt32{200 + 100 * i} or sack[i].right != WrappingInt32{250 + 100 * i},
+                            "SACK block " + to_string(i) + " was corrupted");
+            }
+            test_err_if(parsed.header().doff != 14, "four SACK blocks should take the header to 56 bytes");
+            test_err_if(parsed.header().sack_permitted, "SACK-permitted appeared from nowhere");
+        }
+
+        {
+            TCPSegment seg;
+            seg.header().syn = true;
+            seg.header().window_scale = 7;
+            seg.header().sack_permitted = true;
+
+            TCPSegment parsed;
+            test_err_if(parsed.parse(seg.serialize().concatenate()) != ParseResult::NoError,
+                        "SYN with window scale failed to parse");
+            test_err_if(parsed.header().window_scale != 7, "window scale was lost");
+            test_err_if(not parsed.header().sack_permitted, "SACK-permitted was lost next to the window scale");
+            test_err_if(parsed.header().doff != 7, "window scale and SACK-permitted should take 8 bytes");
+        }
+
+        {
+            TCPSegment seg;
+            seg.header().ack = true;
+            seg.header().timestamps = TCPTimestamps{0xdeadbeef, 12345};
+            for (uint32_t i = 0; i < TCPHeader::MAX_SACK_BLOCKS; i++) {
+                seg.header().sack.push_back({WrappingInt32{200 + 100 * i}, WrappingInt32{250 + 100 * i}});
+            }
+
+            TCPSegment parsed;
+            test_err_if(parsed.parse(seg.serialize().concatenate()) != ParseResult::NoError,
+                        "ACK with timestamps and SACK failed to parse");
+            test_err_if(not parsed.header().timestamps.has_value(), "timestamps were lost");
+            test_err_if(parsed.header().timestamps->tsval != 0xdeadbeef or parsed.header().timestamps->tsecr != 12345,
+                        "timestamps were corrupted");
+            test_err_if(parsed.header().sack.size() != TCPHeader::MAX_SACK_BLOCKS_WITH_TIMESTAMPS,
+                        "only three SACK blocks fit beside timestamps");
+            test_err_if(parsed.header().sack.front().left != WrappingInt32{200}, "the first SACK block should be kept");
+        }
+
+        {
+            TCPSegment seg;
+            seg.header().syn = true;
+            seg.header().mss = 1460;
+            seg.header().window_scale = 14;
+            seg.header().timestamps = TCPTimestamps{1, 0};
+            seg.header().sack_permitted = true;
+
+            TCPSegment parsed;
+            test_err_if(parsed.parse(seg.serialize().concatenate()) != ParseResult::NoError,
+                        "SYN with every option failed to parse");
+            test_err_if(parsed.header().mss != 1460, "MSS was lost");
+            test_err_if(parsed.header().window_scale != 14, "window scale was lost next to the MSS");
+            test_err_if(not parsed.header().timestamps.has_value(), "timestamps were lost next to the MSS");
+            test_err_if(not parsed.header().sack_permitted, "SACK-permitted was lost next to the MSS");
+            test_err_if(parsed.header().doff != 10, "a SYN with every option should take 20 bytes of options");
+        }
+
+        {
+            // An MSS option with a one-byte value is ignored
+            const string options{"\x02\x03\x05\x00", 4};
+            const TCPHeader header = parse_header(raw_header(6, options));
+            test_err_if(header.mss.has_value(), "a short MSS option should be ignored");
+        }
+
+        {
+            // A window scale option with no shift count is ignored
+            const string options{"\x03\x02\x00\x00", 4};
+            const TCPHeader header = parse_header(raw_header(6, options));
+            test_err_if(header.window_scale.has_value(), "a short window scale option should be ignored");
+        }
+
+        {
+            // NOP, an unknown 4-byte option, then SACK-permitted
+            const string options{"\x01\x1e\x04\xab\xab\x04\x02\x00", 8};
+            const TCPHeader header = parse_header(raw_header(7, options));
+            test_err_if(not header.sack_permitted, "options after an unknown option should still be parsed");
+        }
+
+        {
+            // SACK-permitted, then an option whose length runs past the end of the header
+            const string options{"\x04\x02\x05\x20\x00\x00\x00\x01", 8};
+            const TCPHeader header = parse_header(raw_header(7, options));
+            test_err_if(not header.sack_permitted, "options before a malformed option should still be parsed");
+            test_err_if(not header.sack.empty(), "a truncated SACK option should be ignored");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,113 @@
+#include "buffer.hh"
+#include "fd_adapter.hh"
+#include "socket.hh"
+#include "tcp_segment.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+static constexpr size_t SEGMENTS = 50;
+static constexpr size_t PAYLOAD = 100;
+
+//! A data segment with `PAYLOAD` bytes at `seqno`
+static TCPSegment data_segment(const uint32_t seqno) {
+    TCPSegment seg;
+    seg.header().ack = true;
+    seg.header().seqno = WrappingInt32{seqno};
+    seg.payload() = string(PAYLOAD, 'x');
+    return seg;
+}
+
+//! Fail unless the payloads keep at most about twice their bytes (plus their headers) allocated
+static void check_retained(const vector<TCPSegment> &segments, const string &what) {
+    test_err_if(segments.size() != SEGMENTS, what + ": lost segments");
+    size_t retained = 0;
+    for (const auto &seg : segments) {
+        test_err_if(seg.payload().str() != string(PAYLOAD, 'x'), what + ": payload is wrong");
+        retained += seg.payload().storage_capacity();
+    }
+    const size_t datagram_size = SEGMENTS * (TCPHeader::LENGTH + PAYLOAD);
+    test_err_if(retained > 2 * datagram_size,
+                what + ": " + to_string(retained) + " bytes retained for " + to_string(SEGMENTS * PAYLOAD) +
+                    " bytes of payload");
+}
+
+int main() {
+    try {
+        {
+            // a string with much spare capacity is copied into tight storage, and a tight one is not copied
+            string roomy;
+            roomy.reserve(65536);
+            roomy.append(PAYLOAD, 'x');
+            const Buffer compacted = Buffer::compacted(move(roomy));
+            test_err_if(compacted.str() != string(PAYLOAD, 'x'), "compacting changed the bytes");
+            test_err_if(compacted.storage_capacity() > 2 * PAYLOAD, "spare capacity was kept");
+
+            string tight(PAYLOAD, 'y');
+            const char *const data = tight.data();
+            const Buffer kept = Buffer::compacted(move(tight));
+            test_err_if(kept.str().data() != data, "a tight string was copied");
+            test_err_if(Buffer{}.storage_capacity() != 0, "an empty Buffer should keep no storage");
+        }
+
+        UDPSocket sender;
+        sender.bind(Address("127.0.0.1", 0));
+
+        {
+            // segments read by the connection adapter don't keep the 64 KiB receive storage
+            UDPSocket sock;
+            sock.bind(Address("127.0.0.1", 0));
+            const Address receiver = sock.local_address();
+            TCPOverUDPSocketAdapter adapter{move(sock)};
+            adapter.config_mut().destination = sender.local_address();
+
+            for (size_t i = 0; i < SEGMENTS; i++) {
+                sender.sendto(receiver, data_segment(i * PAYLOAD).serialize());
+            }
+
+            vector<TCPSegment> segments;
+            optional<TCPSegment> seg;
+            const auto start = timestamp_ms();
+            while (segments.size() < SEGMENTS and timestamp_ms() - start < 5000) {
+                if (adapter.try_read(seg) and seg) {
+                    segments.push_back(move(seg.value()));
+                }
+            }
+            check_retained(segments, "TCPOverUDPSocketAdapter");
+        }
+
+        {
+            // nor do segments read by the multiplexing adapter
+            UDPSocket sock;
+            sock.bind(Address("127.0.0.1", 0));
+            const Address receiver = sock.local_address();
+            TCPOverUDPMuxAdapter adapter{move(sock)};
+
+            for (size_t i = 0; i < SEGMENTS; i++) {
+                sender.sendto(receiver, data_segment(i * PAYLOAD).serialize());
+            }
+
+            vector<TCPSegment> segments;
+            for (size_t i = 0; i < SEGMENTS; i++) {
+                auto demuxed = adapter.read();
+                test_err_if(not demuxed, "TCPOverUDPMuxAdapter dropped a valid segment");
+                segments.push_back(move(demuxed->segment));
+            }
+            check_retained(segments, "TCPOverUDPMuxAdapter");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
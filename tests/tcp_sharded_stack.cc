@@ -0,0 +1,144 @@
+#include "tcp_sharded_stack.hh"
+#include "tcp_stack.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+static constexpr size_t SHARDS = 4;
+static constexpr size_t CONNECTIONS = 32;
+static constexpr uint16_t PORT = 7;
+
+//! A UDP socket bound to an ephemeral port on the loopback interface
+static UDPSocket loopback_socket() {
+    UDPSocket sock;
+    sock.bind(Address("127.0.0.1", 0));
+    return sock;
+}
+
+//! State of the echo server in one shard (read by the main thread only after ShardedTCPStack::stop())
+struct EchoShard {
+    vector<FourTuple> connections{};
+    size_t accepted{0};
+    size_t misrouted{0};
+};
+
+int main() {
+    try {
+        TCPConfig cfg;
+        cfg.rt_timeout = 20;
+
+        UDPSocket server_sock = loopback_socket();
+        const Address server_address = server_sock.local_address();
+        UDPShardedTCPStack server{TCPOverUDPMuxAdapter{move(server_sock)}, SHARDS, cfg};
+        server.listen(PORT, CONNECTIONS);
+
+        // each worker echoes the data of its shard's connections, and closes each one once the peer has
+        vector<EchoShard> echo(SHARDS);
+        server.start([&](UDPShardedTCPStack::Shard &shard, const size_t index) {
+            EchoShard &mine = echo[index];
+            while (auto id = shard.accept(PORT)) {
+                mine.connections.push_back(id.value());
+                mine.accepted++;
+                if (server.shard_of(id.value()) != index) {
+                    mine.misrouted++;
+                }
+            }
+
+            for (auto it = mine.connections.begin(); it != mine.connections.end();) {
+                ByteStream &inbound = shard.inbound_stream(*it);
+                if (not inbound.buffer_empty()) {
+                    shard.write(*it, inbound.read(inbound.buffer_size()));
+                }
+                if (inbound.eof()) {
+                    shard.end_input_stream(*it);
+                    shard.release(*it);
+                    it = mine.connections.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        });
+
+        UDPTCPStack client{TCPOverUDPMuxAdapter{loopback_socket()}, cfg};
+        vector<FourTuple> ids;
+        vector<string> replies(CONNECTIONS);
+        for (size_t i = 0; i < CONNECTIONS; i++) {
+            ids.push_back(client.connect(server_address, PORT));
+        }
+
+        vector<bool> sent(CONNECTIONS, false);
+        vector<bool> echoed(CONNECTIONS, false);
+        const auto start = timestamp_ms();
+        while (client.connection_count() > 0) {
+            test_err_if(timestamp_ms() - start > 10000, "timed out waiting for the echoes");
+            client.wait_next_event(1);
+            for (size_t i = 0; i < CONNECTIONS; i++) {
+                if (sent[i] or client.connection(ids[i]).state() != TCPState{TCPState::State::ESTABLISHED}) {
+                    continue;
+                }
+                client.write(ids[i], "message " + to_string(i));
+                client.end_input_stream(ids[i]);
+                sent[i] = true;
+            }
+            for (size_t i = 0; i < CONNECTIONS; i++) {
+                if (not sent[i] or echoed[i]) {
+                    continue;
+                }
+                ByteStream &inbound = client.inbound_stream(ids[i]);
+                replies[i] += inbound.read(inbound.buffer_size());
+                if (inbound.eof()) {
+                    echoed[i] = true;
+                    client.release(ids[i]);
+                }
+            }
+        }
+
+        // a burst longer than one dispatch batch reaches the shards, which refuse every SYN to a closed port
+        constexpr size_t BURST = 150;
+        UDPSocket peer = loopback_socket();
+        for (size_t i = 0; i < BURST; i++) {
+            TCPSegment syn;
+            syn.header().syn = true;
+            syn.header().sport = 1000 + i;
+            syn.header().dport = PORT + 1;
+            peer.sendto(server_address, syn.serialize());
+        }
+        size_t resets = 0;
+        const auto burst_start = timestamp_ms();
+        while (resets < BURST) {
+            test_err_if(timestamp_ms() - burst_start > 10000, "timed out waiting for the burst to be refused");
+            UDPSocket::received_datagram datagram{{nullptr, 0}, ""};
+            while (peer.try_recv(datagram)) {
+                resets++;
+            }
+        }
+        server.stop();
+        test_err_if(resets != BURST, "some SYNs in the burst were answered more than once");
+
+        size_t accepted = 0;
+        size_t busy_shards = 0;
+        for (const auto &shard : echo) {
+            test_err_if(shard.misrouted != 0, "a connection was served by the wrong shard");
+            accepted += shard.accepted;
+            busy_shards += shard.accepted > 0;
+        }
+        test_err_if(accepted != CONNECTIONS, "wrong number of accepted connections");
+        test_err_if(busy_shards < 2, "connections were not spread over the shards");
+        for (size_t i = 0; i < CONNECTIONS; i++) {
+            test_err_if(replies[i] != "message " + to_string(i), "wrong echo on connection " + to_string(i));
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
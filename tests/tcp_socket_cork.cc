@@ -0,0 +1,87 @@
+#include "tcp_sponge_socket.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <utility>
+
+using namespace std;
+
+//! Everything the socket has received so far, without waiting for more
+static string read_waiting(TCPOverUDPSpongeSocket &sock) {
+    string ret;
+    string data;
+    while (sock.try_read(data) and not data.empty()) {
+        ret += data;
+    }
+    return ret;
+}
+
+//! Read from the socket until `expected` has arrived, or fail after a few seconds
+static void expect_data(TCPOverUDPSpongeSocket &sock, const string &expected, const string &what) {
+    string received;
+    const auto start = timestamp_ms();
+    while (received.size() < expected.size()) {
+        test_err_if(timestamp_ms() - start > 5000, "timed out waiting for " + what);
+        received += read_waiting(sock);
+        this_thread::sleep_for(chrono::milliseconds(1));
+    }
+    test_err_if(received != expected, "wrong data after " + what);
+}
+
+int main() {
+    try {
+        TCPConfig cfg;
+        cfg.rt_timeout = 20;
+
+        UDPSocket server_sock;
+        server_sock.bind(Address("127.0.0.1", 0));
+        FdAdapterConfig server_cfg;
+        server_cfg.source = server_sock.local_address();
+        TCPOverUDPSpongeSocket server{TCPOverUDPSocketAdapter{move(server_sock)}};
+        thread listener([&] { server.listen_and_accept(cfg, server_cfg); });
+
+        FdAdapterConfig client_cfg;
+        client_cfg.destination = server_cfg.source;
+        TCPOverUDPSpongeSocket client{TCPOverUDPSocketAdapter{UDPSocket{}}};
+        client.connect(cfg, client_cfg);
+        listener.join();
+        server.set_blocking(false);
+
+        // a cork holds back data written right after it, however soon the TCPConnection thread reads the data
+        for (int i = 0; i < 20; i++) {
+            client.cork();
+            client.write("abc");
+            this_thread::sleep_for(chrono::milliseconds(20));
+            test_err_if(not read_waiting(server).empty(), "corked data was sent");
+
+            client.uncork();
+            expect_data(server, "abc", "uncork()");
+        }
+
+        // flush() uncorks, and sends the data written before it
+        client.cork();
+        client.write("de");
+        client.write("f");
+        client.flush();
+        expect_data(server, "def", "flush()");
+
+        // ... and leaves the socket uncorked
+        client.write("g");
+        expect_data(server, "g", "a write after flush()");
+
+        thread closer([&] { client.wait_until_closed(); });
+        server.wait_until_closed();
+        closer.join();
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
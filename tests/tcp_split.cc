@@ -0,0 +1,69 @@
+#include "tcp_segment.hh"
+#include "test_err_if.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        {
+            TCPSegment seg;
+            seg.header().seqno = WrappingInt32{100};
+            seg.payload() = string("abc");
+
+            const auto pieces = seg.split(3);
+            test_err_if(pieces.size() != 1, "a segment that fits should not be split");
+            test_err_if(pieces[0].header().seqno != WrappingInt32{100} or pieces[0].payload().str() != "abc",
+                        "a segment that fits should be returned as is");
+        }
+
+        {
+            TCPSegment seg;
+            seg.header().syn = true;
+            seg.header().fin = true;
+            seg.header().ack = true;
+            seg.header().ackno = WrappingInt32{7};
+            seg.header().seqno = WrappingInt32{UINT32_MAX - 1};
+            seg.header().sack.push_back({WrappingInt32{20}, WrappingInt32{30}});
+            seg.payload() = string("abcdefghij");
+
+            const auto pieces = seg.split(4);
+            test_err_if(pieces.size() != 3, "ten bytes should split into three pieces of at most four");
+
+            const string expected[] = {"abcd", "efgh", "ij"};
+            // the SYN takes the first sequence number, and seqnos wrap
+            const uint32_t expected_seqno[] = {UINT32_MAX - 1, 3, 7};
+            size_t length_in_sequence_space = 0;
+            for (size_t i = 0; i < pieces.size(); i++) {
+                const TCPHeader &header = pieces[i].header();
+                test_err_if(pieces[i].payload().str() != expected[i], "piece " + to_string(i) + " has the wrong data");
+                test_err_if(header.seqno != WrappingInt32{expected_seqno[i]},
+                            "piece " + to_string(i) + " has the wrong seqno");
+                test_err_if(header.syn != (i == 0), "only the first piece should carry SYN");
+                test_err_if(header.fin != (i == pieces.size() - 1), "only the last piece should carry FIN");
+                test_err_if(not header.ack or header.ackno != WrappingInt32{7}, "every piece should carry the ACK");
+                test_err_if(header.sack.size() != 1, "every piece should carry the options");
+                length_in_sequence_space += pieces[i].length_in_sequence_space();
+            }
+            test_err_if(length_in_sequence_space != seg.length_in_sequence_space(),
+                        "the pieces should cover the same sequence space");
+
+            // the pieces survive a round trip through the wire format
+            TCPSegment parsed;
+            test_err_if(parsed.parse(pieces[1].serialize().concatenate()) != ParseResult::NoError,
+                        "a piece failed to parse");
+            test_err_if(parsed.payload().str() != "efgh", "a piece was corrupted on the wire");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,245 @@
+#include "tcp_stack.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <cstdlib>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <optional>
+#include <set>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+//! A stack on a UDP socket bound to an ephemeral port on the loopback interface
+static UDPTCPStack make_stack(const TCPConfig &cfg) {
+    UDPSocket sock;
+    sock.bind(Address("127.0.0.1", 0));
+    return UDPTCPStack{TCPOverUDPMuxAdapter{move(sock)}, cfg};
+}
+
+//! The address that peers of a stack send to
+static Address address_of(UDPTCPStack &stack) {
+    return static_cast<UDPSocket &>(stack.adapter()).local_address();
+}
+
+//! Run both stacks until `done` holds, or fail after a few seconds
+static void run_until(UDPTCPStack &a, UDPTCPStack &b, const function<bool()> &done, const string &what) {
+    const auto start = timestamp_ms();
+    while (not done()) {
+        test_err_if(timestamp_ms() - start > 5000, "timed out waiting for " + what);
+        a.wait_next_event(1);
+        b.wait_next_event(1);
+    }
+}
+
+int main() {
+    try {
+        TCPConfig cfg;
+        cfg.rt_timeout = 20;
+
+        auto server = make_stack(cfg);
+        auto client = make_stack(cfg);
+        const Address server_address = address_of(server);
+
+        // several connections between the same two sockets, told apart by their ports
+        {
+            server.listen(80, 8);
+            test_err_if(server.accept(80).has_value(), "accept() returned a connection before any SYN");
+
+            vector<FourTuple> outbound;
+            for (int i = 0; i < 3; i++) {
+                outbound.push_back(client.connect(server_address, 80));
+            }
+            set<uint16_t> local_ports;
+            for (const auto &id : outbound) {
+                local_ports.insert(id.local_port);
+            }
+            test_err_if(local_ports.size() != 3, "connect() reused a local port");
+
+            vector<FourTuple> inbound;
+            run_until(
+                server,
+                client,
+                [&] {
+                    while (auto id = server.accept(80)) {
+                        inbound.push_back(id.value());
+                    }
+                    return inbound.size() == 3;
+                },
+                "three connections to be accepted");
+
+            for (size_t i = 0; i < 3; i++) {
+                test_err_if(inbound[i].local_port != 80, "accepted connection on the wrong port");
+                test_err_if(inbound[i].remote_port != outbound[i].local_port, "connections accepted out of order");
+                test_err_if(client.connection(outbound[i]).state() != TCPState{TCPState::State::ESTABLISHED},
+                            "client connection not established");
+                client.write(outbound[i], "hello from connection " + to_string(i));
+                client.end_input_stream(outbound[i]);
+            }
+
+            vector<string> received(3);
+            run_until(
+                server,
+                client,
+                [&] {
+                    bool all_ended = true;
+                    for (size_t i = 0; i < 3; i++) {
+                        ByteStream &stream = server.inbound_stream(inbound[i]);
+                        received[i] += stream.read(stream.buffer_size());
+                        all_ended = all_ended and stream.eof();
+                    }
+                    return all_ended;
+                },
+                "data and FINs to arrive");
+            for (size_t i = 0; i < 3; i++) {
+                test_err_if(received[i] != "hello from connection " + to_string(i),
+                            "data went to the wrong connection");
+                server.end_input_stream(inbound[i]);
+                server.release(inbound[i]);
+                client.release(outbound[i]);
+            }
+
+            run_until(
+                server,
+                client,
+                [&] { return server.connection_count() == 0 and client.connection_count() == 0; },
+                "closed connections to be erased");
+        }
+
+        // the backlog limits connections that have not been accepted yet
+        {
+            server.listen(81, 2);
+            vector<FourTuple> outbound;
+            for (int i = 0; i < 3; i++) {
+                outbound.push_back(client.connect(server_address, 81));
+            }
+
+            const auto start = timestamp_ms();
+            run_until(server, client, [&] { return timestamp_ms() - start > 100; }, "the backlog to fill");
+            test_err_if(server.connection_count() != 2, "backlog did not limit the pending connections");
+
+            const auto first = server.accept(81);
+            test_err_if(not first.has_value(), "accept() did not return a pending connection");
+            optional<FourTuple> third;
+            run_until(
+                server,
+                client,
+                [&] {
+                    third = server.accept(81);
+                    return third.has_value() and third->remote_port == outbound[2].local_port;
+                },
+                "the retransmitted SYN to be accepted");
+            test_err_if(server.connection_count() != 3, "wrong number of server connections");
+        }
+
+        // a SYN to a port without a listener is refused with a RST
+        {
+            const FourTuple id = client.connect(server_address, 82);
+            run_until(
+                server, client, [&] { return not client.connection(id).active(); }, "the connection to be refused");
+            test_err_if(not client.inbound_stream(id).error(), "refused connection was not reset");
+        }
+
+        // the adapter's try_read() reads whatever datagram is waiting, valid or not, and never waits for one
+        {
+            UDPSocket sock;
+            sock.bind(Address("127.0.0.1", 0));
+            const Address address = sock.local_address();
+            TCPOverUDPMuxAdapter adapter{move(sock)};
+
+            optional<DemuxedSegment> demuxed{};
+            test_err_if(adapter.try_read(demuxed), "try_read() found a datagram on an empty socket");
+
+            UDPSocket peer;
+            TCPSegment seg;
+            seg.header().sport = 1000;
+            seg.header().dport = 80;
+            peer.sendto(address, seg.serialize());
+            peer.sendto(address, string("not a TCP segment"));
+
+            test_err_if(not adapter.try_read(demuxed) or not demuxed or demuxed->tuple.local_port != 80 or
+                            demuxed->tuple.remote_port != 1000,
+                        "try_read() did not return the waiting segment");
+            test_err_if(not adapter.try_read(demuxed) or demuxed, "try_read() did not drop the invalid datagram");
+            test_err_if(adapter.try_read(demuxed), "try_read() found a datagram on a drained socket");
+        }
+
+        // a burst longer than one receive batch is read in several batches, without new events
+        {
+            constexpr size_t BURST = 150;
+            UDPSocket peer;
+            peer.bind(Address("127.0.0.1", 0));
+            for (size_t i = 0; i < BURST; i++) {
+                TCPSegment syn;
+                syn.header().syn = true;
+                syn.header().sport = 1000 + i;
+                syn.header().dport = 83;
+                peer.sendto(server_address, syn.serialize());
+            }
+
+            size_t resets = 0;
+            const auto start = timestamp_ms();
+            while (resets < BURST) {
+                test_err_if(timestamp_ms() - start > 5000, "timed out waiting for the burst to be refused");
+                server.wait_next_event(1);
+                UDPSocket::received_datagram datagram{{nullptr, 0}, ""};
+                while (peer.try_recv(datagram)) {
+                    resets++;
+                }
+            }
+            test_err_if(resets != BURST, "some SYNs in the burst were answered more than once");
+        }
+
+        // a paced connection that is caught up after a long idle gap sends only a small burst, then keeps its rate
+        {
+            TCPConfig paced = cfg;
+            paced.pacing = true;
+            paced.pacing_rate = 100000;  // 100 bytes per ms
+            auto paced_client = make_stack(paced);
+            server.listen(83, 1);
+            const FourTuple id = paced_client.connect(server_address, 83);
+            optional<FourTuple> accepted;
+            run_until(
+                server,
+                paced_client,
+                [&] {
+                    if (not accepted.has_value()) {
+                        accepted = server.accept(83);
+                    }
+                    return accepted.has_value() and
+                           paced_client.connection(id).state() == TCPState{TCPState::State::ESTABLISHED};
+                },
+                "the paced connection to be established");
+
+            this_thread::sleep_for(chrono::milliseconds(500));
+            const auto start = timestamp_ms();
+            paced_client.write(id, string(20000, 'x'));
+            test_err_if(paced_client.connection(id).bytes_in_flight() > 3 * TCPConfig::MAX_PAYLOAD_SIZE,
+                        "the idle gap released a burst");
+
+            size_t received = 0;
+            run_until(
+                server,
+                paced_client,
+                [&] {
+                    ByteStream &stream = server.inbound_stream(accepted.value());
+                    received += stream.read(stream.buffer_size()).size();
+                    return timestamp_ms() - start >= 100;
+                },
+                "the paced data to flow");
+            const size_t allowed = 3 * TCPConfig::MAX_PAYLOAD_SIZE + 100 * (timestamp_ms() - start);
+            test_err_if(received > allowed, "the paced connection exceeded its rate after an idle gap");
+            test_err_if(received <= 3 * TCPConfig::MAX_PAYLOAD_SIZE, "the paced connection stalled");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,118 @@
+#include "test_err_if.hh"
+#include "timing_wheel.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+using Wheel = TimingWheel<int>;
+
+//! Advance the wheel and return the keys that expired, sorted
+static vector<int> advance_to(Wheel &wheel, const uint64_t now) {
+    vector<int> expired;
+    wheel.advance(now, expired);
+    sort(expired.begin(), expired.end());
+    return expired;
+}
+
+int main() {
+    try {
+        // timers fire on their deadline, at every level
+        {
+            Wheel wheel{1000};
+            const vector<uint64_t> deadlines{1001, 1005, 1063, 1064, 1100, 5000, 300000, 16000000};
+            for (size_t i = 0; i < deadlines.size(); i++) {
+                wheel.schedule(i, deadlines[i]);
+            }
+            test_err_if(wheel.next_expiry() != 1001, "next expiry is not the earliest deadline");
+
+            for (size_t i = 0; i < deadlines.size(); i++) {
+                test_err_if(not advance_to(wheel, deadlines[i] - 1).empty(), "timer fired early");
+                test_err_if(advance_to(wheel, deadlines[i]) != vector<int>{static_cast<int>(i)},
+                            "timer " + to_string(i) + " did not fire on its deadline");
+            }
+            test_err_if(wheel.size() != 0 or wheel.next_expiry().has_value(), "fired timers remain");
+        }
+
+        // rescheduling replaces a timer, and a canceled timer never fires
+        {
+            Wheel wheel;
+            wheel.schedule(1, 10);
+            wheel.schedule(2, 20);
+            wheel.schedule(3, 5000);
+            wheel.schedule(1, 7000);
+            wheel.schedule(3, 30);
+            wheel.cancel(2);
+            test_err_if(wheel.size() != 2, "wrong number of timers");
+            test_err_if(not advance_to(wheel, 29).empty(), "a rescheduled or canceled timer fired");
+            test_err_if(advance_to(wheel, 100) != vector<int>{3}, "a timer brought forward did not fire");
+            test_err_if(advance_to(wheel, 7000) != vector<int>{1}, "a timer pushed back did not fire");
+        }
+
+        // a deadline that has passed fires at the next advance
+        {
+            Wheel wheel{50};
+            wheel.schedule(1, 10);
+            test_err_if(advance_to(wheel, 51) != vector<int>{1}, "a past deadline did not fire");
+        }
+
+        // random operations agree with a simple model, and the next expiry never overshoots
+        {
+            mt19937 rng{1234};
+            Wheel wheel;
+            map<int, uint64_t> model;
+            uint64_t now = 0;
+            for (int step = 0; step < 20000; step++) {
+                const int key = rng() % 64;
+                switch (rng() % 4) {
+                    case 0:
+                    case 1: {
+                        const uint64_t span = uint64_t{1} << (rng() % 20);
+                        const uint64_t deadline = now + 1 + rng() % span;
+                        wheel.schedule(key, deadline);
+                        model[key] = deadline;
+                        break;
+                    }
+                    case 2:
+                        wheel.cancel(key);
+                        model.erase(key);
+                        break;
+                    default: {
+                        const uint64_t next = now + rng() % 5000;
+                        vector<int> expected;
+                        uint64_t earliest = UINT64_MAX;
+                        for (auto it = model.begin(); it != model.end();) {
+                            earliest = min(earliest, it->second);
+                            if (it->second <= next) {
+                                expected.push_back(it->first);
+                                it = model.erase(it);
+                            } else {
+                                ++it;
+                            }
+                        }
+                        const auto expiry = wheel.next_expiry();
+                        test_err_if(expiry.has_value() != (earliest != UINT64_MAX), "next expiry disagrees");
+                        test_err_if(expiry.has_value() and expiry.value() > earliest, "next expiry is too late");
+                        test_err_if(advance_to(wheel, next) != expected, "wrong timers fired");
+                        now = next;
+                        break;
+                    }
+                }
+                test_err_if(wheel.size() != model.size(), "wrong number of timers");
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}